@@ -0,0 +1,471 @@
+// Job system microbenchmarks. Every scenario runs against a fresh
+// ThreadPoolJobSystem for each worker count; the results are printed as a
+// table and written as JSON so runs can be compared across scheduler changes.
+//
+//   gecko_bench_jobs [--workers 1,2,4] [--repetitions 20]
+//                    [--filter chain] [--output gecko_bench_jobs.json]
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "gecko/core/boot.h"
+#include "gecko/core/jobs.h"
+#include "gecko/core/services.h"
+#include "gecko/core/thread.h"
+#include "gecko/core/time.h"
+#include "gecko/core/version.h"
+#include "gecko/runtime/thread_pool_job_system.h"
+
+using namespace gecko;
+
+namespace {
+
+const auto BENCH_CAT = MakeCategory("Bench");
+
+// Room for the largest batch below plus the jobs still retiring from the
+// previous repetition, so no scenario measures pool exhaustion.
+constexpr u32 JobCapacity = 1u << 16;
+
+// Samples of one metric of a scenario. Each sample covers OpsPerSample
+// operations: a whole repetition for "wall_ns", a single job for latencies.
+struct Series {
+  const char *Metric;
+  u64 OpsPerSample;
+  std::vector<u64> Samples;
+};
+
+class Recorder {
+public:
+  void Record(const char *metric, u64 opsPerSample, u64 ns) {
+    for (auto &series : m_Series) {
+      if (std::strcmp(series.Metric, metric) == 0) {
+        series.Samples.push_back(ns);
+        return;
+      }
+    }
+    m_Series.push_back({metric, opsPerSample, {ns}});
+  }
+
+  std::vector<Series> &AllSeries() noexcept { return m_Series; }
+
+private:
+  std::vector<Series> m_Series;
+};
+
+// Times the body of a throughput scenario as one "wall_ns" sample.
+template <typename Fn>
+void RecordWall(Recorder &recorder, u64 ops, Fn &&fn) {
+  const u64 start = MonotonicTimeNs();
+  fn();
+  recorder.Record("wall_ns", ops, MonotonicTimeNs() - start);
+}
+
+// Empty jobs submitted one at a time from a non-worker thread.
+void EmptySubmit(Recorder &recorder) {
+  constexpr u32 Count = 10000;
+  std::vector<JobHandle> handles(Count);
+  RecordWall(recorder, Count, [&] {
+    for (u32 i = 0; i < Count; ++i)
+      handles[i] = SubmitJob([] {}, JobPriority::Normal, BENCH_CAT);
+    WaitForJobs(handles.data(), Count);
+  });
+}
+
+// The same jobs handed over in a single SubmitJobs call.
+void EmptyBatch(Recorder &recorder) {
+  constexpr u32 Count = 10000;
+  std::vector<JobDesc> jobs(Count);
+  std::vector<JobHandle> handles(Count);
+  for (auto &job : jobs) {
+    job.Function = [] {};
+    job.Cat = BENCH_CAT;
+  }
+  RecordWall(recorder, Count, [&] {
+    SubmitJobs(jobs.data(), Count, handles.data());
+    WaitForJobs(handles.data(), Count);
+  });
+}
+
+// One root releases Width jobs that all feed a single sink.
+void FanOutFanIn(Recorder &recorder) {
+  constexpr u32 Width = 1024;
+  std::vector<JobDesc> jobs(Width + 2);
+  std::vector<JobHandle> handles(Width + 2);
+  RecordWall(recorder, Width + 2, [&] {
+    for (auto &job : jobs) {
+      job.Function = [] {};
+      job.Cat = BENCH_CAT;
+    }
+    for (u32 i = 1; i <= Width; ++i) {
+      jobs[i].Dependencies = &handles[0];
+      jobs[i].DependencyCount = 1;
+    }
+    jobs[Width + 1].Dependencies = &handles[1];
+    jobs[Width + 1].DependencyCount = Width;
+    SubmitJobs(jobs.data(), Width + 2, handles.data());
+    WaitForJob(handles[Width + 1]);
+  });
+}
+
+// Every job depends on the previous one, so this measures the hand-off from
+// a finishing job to its successor.
+void DependencyChain(Recorder &recorder) {
+  constexpr u32 Length = 4096;
+  std::vector<JobDesc> jobs(Length);
+  std::vector<JobHandle> handles(Length);
+  RecordWall(recorder, Length, [&] {
+    for (u32 i = 0; i < Length; ++i) {
+      jobs[i].Function = [] {};
+      jobs[i].Cat = BENCH_CAT;
+      if (i > 0) {
+        jobs[i].Dependencies = &handles[i - 1];
+        jobs[i].DependencyCount = 1;
+      }
+    }
+    SubmitJobs(jobs.data(), Length, handles.data());
+    WaitForJob(handles[Length - 1]);
+  });
+}
+
+// Layers of jobs where each job waits on two neighbours of the layer above.
+void WideDag(Recorder &recorder) {
+  constexpr u32 Layers = 16;
+  constexpr u32 Width = 256;
+  constexpr u32 Count = Layers * Width;
+  std::vector<JobDesc> jobs(Count);
+  std::vector<JobHandle> handles(Count);
+  RecordWall(recorder, Count, [&] {
+    for (u32 i = 0; i < Count; ++i) {
+      jobs[i].Function = [] {};
+      jobs[i].Cat = BENCH_CAT;
+      if (i >= Width) {
+        const u32 column = i % Width;
+        jobs[i].Dependencies = &handles[i - Width];
+        jobs[i].DependencyCount = column + 1 < Width ? 2 : 1;
+      }
+    }
+    SubmitJobs(jobs.data(), Count, handles.data());
+    WaitForJobs(&handles[Count - Width], Width);
+  });
+}
+
+// Jobs that submit and wait on their own children, exercising the worker's
+// local deque and help-while-waiting.
+void NestedSubmit(Recorder &recorder) {
+  constexpr u32 Parents = 64;
+  constexpr u32 Children = 64;
+  std::vector<JobHandle> handles(Parents);
+  RecordWall(recorder, Parents * (Children + 1), [&] {
+    for (u32 i = 0; i < Parents; ++i) {
+      handles[i] = SubmitJob(
+          [] {
+            JobHandle children[Children];
+            for (auto &child : children)
+              child = SubmitJob([] {}, JobPriority::Normal, BENCH_CAT);
+            WaitForJobs(children, Children);
+          },
+          JobPriority::Normal, BENCH_CAT);
+    }
+    WaitForJobs(handles.data(), Parents);
+  });
+}
+
+// Round trip of one empty job: submit, run on a worker, Wait returns. The
+// caller spins until the job has started before it waits, so Wait never
+// runs the job itself; "start_latency_ns" is the submit-to-run part alone.
+void WaitLatency(Recorder &recorder) {
+  constexpr u32 Count = 1000;
+  for (u32 i = 0; i < Count; ++i) {
+    std::atomic<u64> started{0};
+    const u64 start = MonotonicTimeNs();
+    const JobHandle handle = SubmitJob(
+        [&started] {
+          started.store(MonotonicTimeNs(), std::memory_order_release);
+        },
+        JobPriority::Normal, BENCH_CAT);
+    u64 runNs;
+    while ((runNs = started.load(std::memory_order_acquire)) == 0)
+      CpuRelax();
+    WaitForJob(handle);
+    const u64 end = MonotonicTimeNs();
+    recorder.Record("latency_ns", 1, end - start);
+    recorder.Record("start_latency_ns", 1, runNs - start);
+  }
+}
+
+// A backlog of short jobs with interleaved priorities; reports how long each
+// priority waits from submit until its job finishes.
+void MixedPriorities(Recorder &recorder) {
+  constexpr u32 Count = 3000;
+  constexpr u64 WorkNs = 500;
+  static constexpr const char *Metrics[] = {
+      "low_latency_ns", "normal_latency_ns", "high_latency_ns"};
+
+  std::vector<u64> submitted(Count);
+  std::vector<u64> finished(Count);
+  std::vector<JobHandle> handles(Count);
+  RecordWall(recorder, Count, [&] {
+    for (u32 i = 0; i < Count; ++i) {
+      u64 *end = &finished[i];
+      submitted[i] = MonotonicTimeNs();
+      handles[i] = SubmitJob(
+          [end] {
+            SpinWaitNs(WorkNs);
+            *end = MonotonicTimeNs();
+          },
+          static_cast<JobPriority>(i % 3), BENCH_CAT);
+    }
+    WaitForJobs(handles.data(), Count);
+  });
+  for (u32 i = 0; i < Count; ++i)
+    recorder.Record(Metrics[i % 3], 1, finished[i] - submitted[i]);
+}
+
+struct Scenario {
+  const char *Name;
+  void (*Run)(Recorder &recorder);
+};
+
+constexpr Scenario Scenarios[] = {
+    {"empty_submit", EmptySubmit},
+    {"empty_batch", EmptyBatch},
+    {"fan_out_fan_in", FanOutFanIn},
+    {"dependency_chain", DependencyChain},
+    {"wide_dag", WideDag},
+    {"nested_submit", NestedSubmit},
+    {"wait_latency", WaitLatency},
+    {"mixed_priorities", MixedPriorities},
+};
+
+struct Summary {
+  u64 Min{0};
+  u64 P50{0};
+  u64 P90{0};
+  u64 P99{0};
+  u64 Max{0};
+  u64 Mean{0};
+};
+
+// Nearest-rank percentile of sorted samples.
+u64 Percentile(const std::vector<u64> &sorted, double percentile) noexcept {
+  const double rank =
+      std::ceil(percentile / 100.0 * static_cast<double>(sorted.size()));
+  const size_t index = rank < 1.0 ? 0 : static_cast<size_t>(rank) - 1;
+  return sorted[std::min(index, sorted.size() - 1)];
+}
+
+Summary Summarize(std::vector<u64> &samples) {
+  Summary summary;
+  if (samples.empty())
+    return summary;
+  std::sort(samples.begin(), samples.end());
+  u64 sum = 0;
+  for (u64 sample : samples)
+    sum += sample;
+  summary.Min = samples.front();
+  summary.P50 = Percentile(samples, 50.0);
+  summary.P90 = Percentile(samples, 90.0);
+  summary.P99 = Percentile(samples, 99.0);
+  summary.Max = samples.back();
+  summary.Mean = sum / samples.size();
+  return summary;
+}
+
+struct Result {
+  std::string Scenario;
+  std::string Metric;
+  u32 Workers{0};
+  u64 OpsPerSample{0};
+  u64 SampleCount{0};
+  Summary Stats;
+};
+
+struct Options {
+  std::vector<u32> Workers;
+  u32 Repetitions{20};
+  const char *Filter{nullptr};
+  const char *Output{"gecko_bench_jobs.json"};
+};
+
+// 1, 2, 4, ... up to the hardware thread count, which is always included.
+std::vector<u32> DefaultWorkerCounts() {
+  const u32 hardware = HardwareThreadCount();
+  std::vector<u32> counts;
+  for (u32 count = 1; count < hardware; count *= 2)
+    counts.push_back(count);
+  counts.push_back(hardware);
+  return counts;
+}
+
+bool ParseWorkerList(const char *text, std::vector<u32> &out) {
+  out.clear();
+  while (*text) {
+    char *end = nullptr;
+    const unsigned long count = std::strtoul(text, &end, 10);
+    if (end == text || count == 0)
+      return false;
+    out.push_back(static_cast<u32>(count));
+    text = *end == ',' ? end + 1 : end;
+    if (*end != ',' && *end != '\0')
+      return false;
+  }
+  return !out.empty();
+}
+
+void PrintUsage() {
+  std::fprintf(stderr,
+               "usage: gecko_bench_jobs [--workers 1,2,4] "
+               "[--repetitions N] [--filter NAME] [--output FILE]\n");
+}
+
+bool ParseOptions(int argc, char **argv, Options &options) {
+  options.Workers = DefaultWorkerCounts();
+  for (int i = 1; i < argc; ++i) {
+    const char *arg = argv[i];
+    const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (!value)
+      return false;
+    if (std::strcmp(arg, "--workers") == 0) {
+      if (!ParseWorkerList(value, options.Workers))
+        return false;
+    } else if (std::strcmp(arg, "--repetitions") == 0) {
+      options.Repetitions = static_cast<u32>(std::strtoul(value, nullptr, 10));
+      if (options.Repetitions == 0)
+        return false;
+    } else if (std::strcmp(arg, "--filter") == 0) {
+      options.Filter = value;
+    } else if (std::strcmp(arg, "--output") == 0) {
+      options.Output = value;
+    } else {
+      return false;
+    }
+    ++i;
+  }
+  return true;
+}
+
+bool RunWorkerCount(const Options &options, u32 workers,
+                    std::vector<Result> &results) {
+  runtime::ThreadPoolJobSystem jobSystem;
+  jobSystem.SetWorkerThreadCount(workers);
+  jobSystem.SetJobCapacity(JobCapacity);
+  if (!InstallServices(Services{.JobSystem = &jobSystem})) {
+    std::fprintf(stderr, "failed to start %u workers\n", workers);
+    return false;
+  }
+
+  for (const auto &scenario : Scenarios) {
+    if (options.Filter && !std::strstr(scenario.Name, options.Filter))
+      continue;
+
+    // The first run only warms up the job pool, caches and parked workers
+    Recorder warmUp;
+    scenario.Run(warmUp);
+
+    Recorder recorder;
+    for (u32 i = 0; i < options.Repetitions; ++i)
+      scenario.Run(recorder);
+
+    for (auto &series : recorder.AllSeries()) {
+      Result result;
+      result.Scenario = scenario.Name;
+      result.Metric = series.Metric;
+      result.Workers = workers;
+      result.OpsPerSample = series.OpsPerSample;
+      result.SampleCount = series.Samples.size();
+      result.Stats = Summarize(series.Samples);
+
+      std::printf("%-18s %-18s %3u %10llu %10llu %10llu %10llu\n",
+                  result.Scenario.c_str(), result.Metric.c_str(), workers,
+                  static_cast<unsigned long long>(result.Stats.Min),
+                  static_cast<unsigned long long>(result.Stats.P50),
+                  static_cast<unsigned long long>(result.Stats.P90),
+                  static_cast<unsigned long long>(result.Stats.P99));
+      results.push_back(std::move(result));
+    }
+  }
+
+  UninstallServices();
+  return true;
+}
+
+// Operations per second at the median repetition.
+double Throughput(const Result &result) noexcept {
+  if (result.Stats.P50 == 0)
+    return 0.0;
+  return static_cast<double>(result.OpsPerSample) * 1e9 /
+         static_cast<double>(result.Stats.P50);
+}
+
+bool WriteJson(const char *path, const Options &options,
+               const std::vector<Result> &results) {
+  std::FILE *file = std::fopen(path, "w");
+  if (!file)
+    return false;
+
+  std::fprintf(file, "{\n");
+  std::fprintf(file, "  \"benchmark\": \"gecko_bench_jobs\",\n");
+  std::fprintf(file, "  \"version\": \"%s\",\n", VersionFullString());
+  std::fprintf(file, "  \"hardware_threads\": %u,\n", HardwareThreadCount());
+  std::fprintf(file, "  \"repetitions\": %u,\n", options.Repetitions);
+  std::fprintf(file, "  \"results\": [");
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result &result = results[i];
+    const Summary &stats = result.Stats;
+    std::fprintf(file, "%s\n    {", i == 0 ? "" : ",");
+    std::fprintf(file, "\"scenario\": \"%s\", \"metric\": \"%s\", ",
+                 result.Scenario.c_str(), result.Metric.c_str());
+    std::fprintf(file,
+                 "\"workers\": %u, \"ops_per_sample\": %llu, "
+                 "\"samples\": %llu, ",
+                 result.Workers,
+                 static_cast<unsigned long long>(result.OpsPerSample),
+                 static_cast<unsigned long long>(result.SampleCount));
+    std::fprintf(file,
+                 "\"min\": %llu, \"p50\": %llu, \"p90\": %llu, "
+                 "\"p99\": %llu, \"max\": %llu, \"mean\": %llu, ",
+                 static_cast<unsigned long long>(stats.Min),
+                 static_cast<unsigned long long>(stats.P50),
+                 static_cast<unsigned long long>(stats.P90),
+                 static_cast<unsigned long long>(stats.P99),
+                 static_cast<unsigned long long>(stats.Max),
+                 static_cast<unsigned long long>(stats.Mean));
+    if (std::strcmp(result.Metric.c_str(), "wall_ns") == 0)
+      std::fprintf(file, "\"ops_per_sec\": %.0f, ", Throughput(result));
+    std::fprintf(file, "\"unit\": \"ns\"}");
+  }
+  std::fprintf(file, "\n  ]\n}\n");
+  return std::fclose(file) == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    PrintUsage();
+    return EXIT_FAILURE;
+  }
+
+  std::printf("%-18s %-18s %3s %10s %10s %10s %10s\n", "scenario", "metric",
+              "w", "min ns", "p50 ns", "p90 ns", "p99 ns");
+
+  std::vector<Result> results;
+  for (u32 workers : options.Workers) {
+    if (!RunWorkerCount(options, workers, results))
+      return EXIT_FAILURE;
+  }
+
+  if (!WriteJson(options.Output, options, results)) {
+    std::fprintf(stderr, "failed to write %s\n", options.Output);
+    return EXIT_FAILURE;
+  }
+  std::printf("wrote %zu results to %s\n", results.size(), options.Output);
+  return EXIT_SUCCESS;
+}
@@ -1,14 +1,24 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstdio>
 #include <cstring>
+#include <numeric>
+#include <thread>
 #include <vector>
 
 #include "gecko/core/boot.h"
 #include "gecko/core/category.h"
+#include "gecko/core/job_graph.h"
+#include "gecko/core/job_group.h"
 #include "gecko/core/log.h"
 #include "gecko/core/memory.h"
+#include "gecko/core/parallel.h"
+#include "gecko/core/pipeline.h"
 #include "gecko/core/profiler.h"
 #include "gecko/core/random.h"
 #include "gecko/core/services.h"
+#include "gecko/core/task.h"
 #include "gecko/core/thread.h"
 #include "gecko/core/time.h"
 #include "gecko/core/version.h"
@@ -16,6 +26,7 @@
 #include "gecko/runtime/file_log_sink.h"
 #include "gecko/runtime/ring_logger.h"
 #include "gecko/runtime/ring_profiler.h"
+#include "gecko/runtime/thread_caching_allocator.h"
 #include "gecko/runtime/thread_pool_job_system.h"
 #include "gecko/runtime/trace_file_sink.h"
 #include "gecko/runtime/tracking_allocator.h"
@@ -29,6 +40,18 @@ const auto MEMORY_CAT = MakeCategory("Memory");
 const auto COMPUTE_CAT = MakeCategory("Compute");
 const auto SIMULATION_CAT = MakeCategory("Simulation");
 
+// The demo doubles as a smoke test: a failed check is logged and fails the
+// run, in release builds too
+int g_FailedChecks = 0;
+
+#define EXAMPLE_CHECK(condition)                                               \
+  do {                                                                         \
+    if (!(condition)) {                                                        \
+      GECKO_ERROR(MAIN_CAT, "Check failed: %s", #condition);                   \
+      ++g_FailedChecks;                                                        \
+    }                                                                          \
+  } while (0)
+
 // Simple data structure for our simulation
 struct Particle {
   float x, y, z;
@@ -126,6 +149,161 @@ void WorkerTask(int workerId, int numParticles) {
   }
 }
 
+// Async pipeline: each stage hands the coroutine back to the pool instead of
+// blocking a worker while it waits
+Task<int> LoadAndDecodeAsset(int assetId) {
+  co_await ResumeOnWorker(JobPriority::Normal, COMPUTE_CAT);
+  GECKO_INFO(COMPUTE_CAT, "Asset %d: loading", assetId);
+  SleepMs(10);
+
+  int decodedBytes = 0;
+  JobHandle decode = SubmitJob(
+      [&decodedBytes, assetId]() {
+        GECKO_INFO(COMPUTE_CAT, "Asset %d: decoding", assetId);
+        SleepMs(10);
+        decodedBytes = 1024 * (assetId + 1);
+      },
+      JobPriority::Normal, COMPUTE_CAT);
+  co_await decode;
+
+  GECKO_INFO(COMPUTE_CAT, "Asset %d: uploading %d bytes", assetId,
+             decodedBytes);
+  co_return decodedBytes;
+}
+
+Task<int> LoadAssets(int count) {
+  // Start every load up front so they run side by side, then collect them
+  std::vector<Task<int>> loads;
+  for (int i = 0; i < count; ++i) {
+    loads.push_back(LoadAndDecodeAsset(i));
+    loads.back().Start();
+  }
+
+  int totalBytes = 0;
+  for (auto &load : loads)
+    totalBytes += co_await load;
+  co_return totalBytes;
+}
+
+// Fork-join: each level forks one half into the group and keeps the other
+u64 SumRange(u64 begin, u64 end) {
+  if (end - begin <= 4096) {
+    u64 sum = 0;
+    for (u64 i = begin; i < end; ++i)
+      sum += i;
+    return sum;
+  }
+
+  const u64 middle = begin + (end - begin) / 2;
+  u64 left = 0;
+  JobGroup group;
+  group.Run([&left, begin, middle]() { left = SumRange(begin, middle); },
+            JobPriority::Normal, COMPUTE_CAT);
+  const u64 right = SumRange(middle, end);
+  group.Wait();
+  return left + right;
+}
+
+// Runs each parallel algorithm against its std:: counterpart, at sizes on
+// both sides of ParallelMinBlockSize so the serial and blocked paths and
+// ragged last blocks are all covered
+void CheckParallelAlgorithms() {
+  GECKO_PROF_FUNC(COMPUTE_CAT);
+
+  struct Record {
+    u32 Key;
+    u32 Index;
+  };
+  const auto byKey = [](const Record &a, const Record &b) {
+    return a.Key < b.Key;
+  };
+  const auto isOdd = [](u64 value) { return value % 2 == 1; };
+
+  const u64 sizes[] = {0,
+                       1,
+                       ParallelMinBlockSize - 1,
+                       ParallelMinBlockSize,
+                       ParallelMinBlockSize + 1,
+                       3 * ParallelMinBlockSize + 7,
+                       100003};
+  for (const u64 size : sizes) {
+    std::vector<u64> values(size);
+    for (u64 i = 0; i < size; ++i)
+      values[i] = (i * 2654435761u) % 1000;
+
+    EXAMPLE_CHECK(ParallelReduce(values.begin(), values.end(), u64{3},
+                                 std::plus<>{}, COMPUTE_CAT) ==
+                  std::reduce(values.begin(), values.end(), u64{3}));
+    EXAMPLE_CHECK(
+        ParallelTransformReduce(
+            values.begin(), values.end(), u64{0},
+            [](u64 a, u64 b) { return std::max(a, b); },
+            [](u64 value) { return value * value; }, COMPUTE_CAT) ==
+        std::transform_reduce(
+            values.begin(), values.end(), u64{0},
+            [](u64 a, u64 b) { return std::max(a, b); },
+            [](u64 value) { return value * value; }));
+
+    std::vector<u64> scanned(size);
+    std::vector<u64> expected(size);
+    ParallelInclusiveScan(values.begin(), values.end(), scanned.begin(),
+                          std::plus<>{}, COMPUTE_CAT);
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    EXAMPLE_CHECK(scanned == expected);
+    ParallelExclusiveScan(values.begin(), values.end(), scanned.begin(),
+                          u64{5}, std::plus<>{}, COMPUTE_CAT);
+    std::exclusive_scan(values.begin(), values.end(), expected.begin(),
+                        u64{5});
+    EXAMPLE_CHECK(scanned == expected);
+    scanned = values;
+    ParallelInclusiveScan(scanned.begin(), scanned.end(), scanned.begin(),
+                          std::plus<>{}, COMPUTE_CAT);
+    std::inclusive_scan(values.begin(), values.end(), expected.begin());
+    EXAMPLE_CHECK(scanned == expected);
+
+    std::vector<u64> odd(size);
+    const auto oddEnd = ParallelCompact(values.begin(), values.end(),
+                                        odd.begin(), isOdd, COMPUTE_CAT);
+    odd.erase(oddEnd, odd.end());
+    expected.clear();
+    std::copy_if(values.begin(), values.end(), std::back_inserter(expected),
+                 isOdd);
+    EXAMPLE_CHECK(odd == expected);
+
+    std::vector<u64> partitioned = values;
+    expected = values;
+    const auto split = ParallelPartition(
+        partitioned.begin(), partitioned.end(), isOdd, COMPUTE_CAT);
+    const auto expectedSplit =
+        std::stable_partition(expected.begin(), expected.end(), isOdd);
+    EXAMPLE_CHECK(partitioned == expected &&
+                  split - partitioned.begin() ==
+                      expectedSplit - expected.begin());
+
+    // Equal keys keep their input order in both sorts
+    std::vector<Record> records(size);
+    for (u64 i = 0; i < size; ++i)
+      records[i] = {static_cast<u32>(values[i]), static_cast<u32>(i)};
+    std::vector<Record> stableSorted = records;
+    std::stable_sort(stableSorted.begin(), stableSorted.end(), byKey);
+    const auto sameRecords = [](const std::vector<Record> &a,
+                                const std::vector<Record> &b) {
+      return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                        [](const Record &x, const Record &y) {
+                          return x.Key == y.Key && x.Index == y.Index;
+                        });
+    };
+    std::vector<Record> sorted = records;
+    ParallelMergeSort(sorted.begin(), sorted.end(), byKey, COMPUTE_CAT);
+    EXAMPLE_CHECK(sameRecords(sorted, stableSorted));
+    sorted = records;
+    ParallelRadixSort(
+        sorted.begin(), sorted.end(),
+        [](const Record &record) { return record.Key; }, COMPUTE_CAT);
+    EXAMPLE_CHECK(sameRecords(sorted, stableSorted));
+  }
+}
+
 // Function to perform some memory stress testing
 void MemoryStressTest() {
   GECKO_PROF_FUNC(MEMORY_CAT);
@@ -225,6 +403,87 @@ void MemoryStressTest() {
   GECKO_INFO(MEMORY_CAT, "Memory stress test completed successfully");
 }
 
+// Runs a ThreadCachingAllocator under its own TrackingAllocator, the chain
+// an application would install: Tracking -> ThreadCaching -> System
+void ThreadCachingAllocatorTest() {
+  GECKO_PROF_FUNC(MEMORY_CAT);
+
+  SystemAllocator system;
+  runtime::ThreadCachingAllocator cache(&system);
+  runtime::TrackingAllocator tracking(&cache);
+  EXAMPLE_CHECK(cache.Init() && tracking.Init());
+
+  // Blocks allocated on one thread and freed on another
+  constexpr u32 blockCount = 256;
+  unsigned char *blocks[blockCount] = {};
+  std::thread([&] {
+    for (u32 i = 0; i < blockCount; ++i) {
+      const u64 size = 16 + (i % 40) * 24;
+      blocks[i] =
+          static_cast<unsigned char *>(tracking.Alloc(size, 16, MEMORY_CAT));
+      if (blocks[i])
+        std::memset(blocks[i], static_cast<int>(i), size);
+    }
+  }).join();
+  bool crossThreadIntact = true;
+  std::thread([&] {
+    for (u32 i = 0; i < blockCount; ++i) {
+      const u64 size = 16 + (i % 40) * 24;
+      if (!blocks[i] || blocks[i][size - 1] != static_cast<unsigned char>(i))
+        crossThreadIntact = false;
+      tracking.Free(blocks[i], size, 16, MEMORY_CAT);
+    }
+  }).join();
+  EXAMPLE_CHECK(crossThreadIntact);
+
+  // Unsized free: the block goes back to this thread's cache and is the
+  // next one handed out for its size class
+  void *unsized = cache.Alloc(100, 16, MEMORY_CAT);
+  cache.Free(unsized, 0, 16, MEMORY_CAT);
+  void *reused = cache.Alloc(100, 16, MEMORY_CAT);
+  EXAMPLE_CHECK(unsized && reused == unsized);
+  cache.Free(reused, 0, 16, MEMORY_CAT);
+
+  // Over-aligned requests, and sizes past the small classes that pass
+  // straight through to upstream without touching the spans
+  for (u32 alignment : {32u, 64u, 256u, 4096u}) {
+    void *aligned = tracking.Alloc(200, alignment, MEMORY_CAT);
+    const auto address = reinterpret_cast<uintptr_t>(aligned);
+    EXAMPLE_CHECK(aligned && address % alignment == 0);
+    if (aligned)
+      std::memset(aligned, 0xAB, 200);
+    tracking.Free(aligned, 200, alignment, MEMORY_CAT);
+  }
+  const u64 largeSize = runtime::ThreadCachingAllocator::MaxSmallSize * 2;
+  const u64 reservedBeforeLarge = cache.ReservedBytes();
+  void *large = tracking.Alloc(largeSize, 16, MEMORY_CAT);
+  EXAMPLE_CHECK(large && cache.ReservedBytes() == reservedBeforeLarge);
+  if (large)
+    std::memset(large, 0xCD, largeSize);
+  tracking.Free(large, largeSize, 16, MEMORY_CAT);
+
+  // Threads that exit with blocks in their cache hand them back, so the
+  // next thread reuses them instead of carving new spans
+  const u64 reservedBeforeThreads = cache.ReservedBytes();
+  for (int round = 0; round < 16; ++round) {
+    std::thread([&tracking] {
+      void *cached[400];
+      for (void *&block : cached)
+        block = tracking.Alloc(48, 16, MEMORY_CAT);
+      for (void *block : cached)
+        tracking.Free(block, 48, 16, MEMORY_CAT);
+    }).join();
+  }
+  EXAMPLE_CHECK(cache.ReservedBytes() <=
+                reservedBeforeThreads +
+                    2 * runtime::ThreadCachingAllocator::SpanSize);
+  EXAMPLE_CHECK(tracking.TotalLiveBytes() == 0);
+
+  GECKO_INFO(MEMORY_CAT, "Thread-caching allocator holds %llu bytes in spans",
+             static_cast<unsigned long long>(cache.ReservedBytes()));
+  cache.Shutdown();
+}
+
 void PrintMemoryStats(const runtime::TrackingAllocator &tracker) {
   GECKO_PROF_FUNC(MAIN_CAT);
 
@@ -357,6 +616,7 @@ int main() {
     // 1. Memory Test
     GECKO_INFO(MAIN_CAT, "=== 1. Memory Management Demo ===");
     MemoryStressTest();
+    ThreadCachingAllocatorTest();
     PrintMemoryStats(trackingAlloc);
 
     // 2. Threading Utilities Demo
@@ -397,7 +657,8 @@ int main() {
     GECKO_INFO(MAIN_CAT, "Launching %d parallel physics simulations!",
                numWorkers);
 
-    std::vector<JobHandle> simulationJobs;
+    JobDesc simulationDescs[numWorkers];
+    JobHandle simulationJobs[numWorkers];
 
     GECKO_INFO(MAIN_CAT, "Submitting %d particle simulation jobs to job system",
                numWorkers);
@@ -411,19 +672,21 @@ int main() {
             "Physics Worker %d: Simulating %d particles in zero-gravity!", i,
             particleCount);
 
-        auto job = [i, particleCount]() { WorkerTask(i, particleCount); };
-
-        auto handle = SubmitJob(job, JobPriority::Normal, WORKER_CAT);
-        simulationJobs.push_back(handle);
+        simulationDescs[i].Function = [i, particleCount]() {
+          WorkerTask(i, particleCount);
+        };
+        simulationDescs[i].Cat = WORKER_CAT;
       }
+
+      // One call queues every job and wakes only as many workers as needed
+      SubmitJobs(simulationDescs, numWorkers, simulationJobs);
     }
 
     // Wait for all simulation jobs to complete
     GECKO_INFO(MAIN_CAT, "Waiting for simulation jobs to complete...");
     {
       GECKO_PROF_SCOPE(MAIN_CAT, "WaitForSimulationJobs");
-      WaitForJobs(simulationJobs.data(),
-                  static_cast<u32>(simulationJobs.size()));
+      WaitForJobs(simulationJobs, numWorkers);
     }
 
     GECKO_INFO(MAIN_CAT, "Simulation jobs completed successfully");
@@ -472,28 +735,55 @@ int main() {
     {
       GECKO_PROF_SCOPE(MAIN_CAT, "JobSystemDemo");
 
-      std::vector<JobHandle> jobHandles;
       const int numJobs = 6; // Sweet spot for demo
 
-      // Submit some parallel jobs
-      GECKO_INFO(MAIN_CAT, "Submitting %d parallel jobs...", numJobs);
-      for (int i = 0; i < numJobs; ++i) {
-        auto job = [i]() {
-          GECKO_INFO(COMPUTE_CAT,
-                     "Parallel Worker %d: Processing data chunk...", i);
-          // Simulate interesting computational work
-          SleepMs(15 + i * 8);
-          GECKO_PROF_COUNTER(COMPUTE_CAT, "parallel_jobs_completed", 1);
-        };
-
-        auto handle = SubmitJob(job, JobPriority::Normal, COMPUTE_CAT);
-        jobHandles.push_back(handle);
-      }
-
-      // Wait for all parallel jobs to complete
-      GECKO_INFO(MAIN_CAT, "Waiting for all parallel jobs to complete...");
-      WaitForJobs(jobHandles.data(), static_cast<u32>(jobHandles.size()));
-      GECKO_INFO(MAIN_CAT, "All parallel jobs completed!");
+      // Run a parallel loop; each iteration is heavy enough to be its own
+      // chunk, so use a grain of 1
+      GECKO_INFO(MAIN_CAT, "Running %d parallel iterations...", numJobs);
+      ParallelFor(
+          0, numJobs, 1,
+          [](u64 i) {
+            GECKO_INFO(COMPUTE_CAT,
+                       "Parallel Worker %d: Processing data chunk...",
+                       static_cast<int>(i));
+            // Simulate interesting computational work
+            SleepMs(15 + static_cast<u32>(i) * 8);
+            GECKO_PROF_COUNTER(COMPUTE_CAT, "parallel_jobs_completed", 1);
+          },
+          JobPriority::Normal, COMPUTE_CAT);
+      GECKO_INFO(MAIN_CAT, "All parallel iterations completed!");
+
+      // Cheap iterations: let ParallelFor pick the chunk size
+      std::vector<u64> squares(100000);
+      ParallelForEach(squares, AutoGrain, [&squares](u64 &value) {
+        const auto index = static_cast<u64>(&value - squares.data());
+        value = index * index;
+      });
+      GECKO_INFO(MAIN_CAT, "Auto-grain ParallelForEach filled %zu squares",
+                 squares.size());
+
+      // Parallel algorithms: sort scrambled keys, then keep the even ones
+      std::vector<u32> keys(squares.size());
+      ParallelFor(0, keys.size(), 4096, [&keys](u64 i) {
+        keys[i] = static_cast<u32>(i * 2654435761u);
+      });
+      std::vector<u32> expectedKeys = keys;
+      std::sort(expectedKeys.begin(), expectedKeys.end());
+      ParallelRadixSort(keys.begin(), keys.end(), COMPUTE_CAT);
+      EXAMPLE_CHECK(keys == expectedKeys);
+      std::vector<u32> evenKeys(keys.size());
+      const auto evenEnd =
+          ParallelCompact(keys.begin(), keys.end(), evenKeys.begin(),
+                          [](u32 key) { return key % 2 == 0; }, COMPUTE_CAT);
+      EXAMPLE_CHECK(evenEnd - evenKeys.begin() ==
+                    std::count_if(keys.begin(), keys.end(),
+                                  [](u32 key) { return key % 2 == 0; }));
+      EXAMPLE_CHECK(std::all_of(evenKeys.begin(), evenEnd,
+                                [](u32 key) { return key % 2 == 0; }));
+      EXAMPLE_CHECK(std::is_sorted(evenKeys.begin(), evenEnd));
+      GECKO_INFO(MAIN_CAT, "Sorted %zu keys, %zu of them even", keys.size(),
+                 static_cast<size_t>(evenEnd - evenKeys.begin()));
+      CheckParallelAlgorithms();
 
       // Example with job dependencies - pipeline pattern
       GECKO_INFO(MAIN_CAT, "Testing job dependencies (pipeline pattern)...");
@@ -533,6 +823,297 @@ int main() {
       WaitForJob(dataFinalizationJob);
       GECKO_INFO(MAIN_CAT, "Job dependency pipeline completed successfully!");
 
+      // Timed jobs run in deadline order whatever order they were submitted
+      // in, and a cancelled periodic job never runs again
+      GECKO_INFO(MAIN_CAT, "Testing timed and periodic jobs...");
+      {
+        std::atomic<int> order{0};
+        int lateRank = -1;
+        int earlyRank = -1;
+        const u64 submitNs = MonotonicTimeNs();
+        JobHandle timedJobs[] = {
+            SubmitJobAt([&order, &lateRank]() { lateRank = order++; },
+                        submitNs + 20000000, JobPriority::Normal,
+                        COMPUTE_CAT),
+            SubmitJobAt([&order, &earlyRank]() { earlyRank = order++; },
+                        submitNs + 5000000, JobPriority::Normal,
+                        COMPUTE_CAT)};
+        WaitForJobs(timedJobs, 2);
+        EXAMPLE_CHECK(earlyRank == 0 && lateRank == 1);
+        EXAMPLE_CHECK(MonotonicTimeNs() - submitNs >= 20000000);
+
+        std::atomic<int> ticks{0};
+        PeriodicJob ticker = SubmitPeriodicJob(
+            [&ticks]() { ++ticks; }, 2000000, JobPriority::Low, COMPUTE_CAT);
+        EXAMPLE_CHECK(ticker.IsValid());
+        SleepMs(20);
+        CancelPeriodicJob(ticker);
+        const int ticksAtCancel = ticks.load();
+        SleepMs(10);
+        EXAMPLE_CHECK(ticksAtCancel > 0 && ticks.load() == ticksAtCancel);
+        GECKO_INFO(MAIN_CAT, "Periodic job ticked %d times before cancel",
+                   ticksAtCancel);
+      }
+
+      // Declared resource access orders jobs without explicit handles: the
+      // readers wait for the first writer, and the second writer waits for
+      // both readers
+      GECKO_INFO(MAIN_CAT, "Testing jobs ordered by resource access...");
+      {
+        const u64 sceneResource = FNV1a("Scene");
+        std::atomic<int> order{0};
+        int sceneVersion = 0;
+        int writeRanks[2] = {-1, -1};
+        int readRanks[2] = {-1, -1};
+        int versionsRead[2] = {0, 0};
+
+        JobDesc sceneJobs[4];
+        sceneJobs[0].Function = [&]() {
+          SleepMs(5);
+          sceneVersion = 1;
+          writeRanks[0] = order++;
+        };
+        sceneJobs[0].Writes = &sceneResource;
+        sceneJobs[0].WriteCount = 1;
+        for (int reader = 0; reader < 2; ++reader) {
+          sceneJobs[1 + reader].Function = [&, reader]() {
+            SleepMs(5);
+            versionsRead[reader] = sceneVersion;
+            readRanks[reader] = order++;
+          };
+          sceneJobs[1 + reader].Reads = &sceneResource;
+          sceneJobs[1 + reader].ReadCount = 1;
+        }
+        sceneJobs[3].Function = [&]() {
+          sceneVersion = 2;
+          writeRanks[1] = order++;
+        };
+        sceneJobs[3].Writes = &sceneResource;
+        sceneJobs[3].WriteCount = 1;
+        for (JobDesc &desc : sceneJobs)
+          desc.Cat = COMPUTE_CAT;
+
+        JobHandle sceneHandles[4];
+        SubmitJobs(sceneJobs, 4, sceneHandles);
+        WaitForJobs(sceneHandles, 4);
+        EXAMPLE_CHECK(writeRanks[0] == 0 && writeRanks[1] == 3);
+        EXAMPLE_CHECK(readRanks[0] > 0 && readRanks[0] < 3);
+        EXAMPLE_CHECK(readRanks[1] > 0 && readRanks[1] < 3);
+        EXAMPLE_CHECK(versionsRead[0] == 1 && versionsRead[1] == 1);
+        EXAMPLE_CHECK(sceneVersion == 2);
+      }
+
+      // Cancelling a token drops its pending job and everything downstream
+      // of it, whether or not they carry the token themselves
+      GECKO_INFO(MAIN_CAT, "Testing job cancellation...");
+      {
+        const u64 cancelledBefore = jobSystem.Stats().JobsCancelled;
+        std::atomic<bool> release{false};
+        std::atomic<int> ran{0};
+        CancellationToken token;
+
+        const JobHandle blocker = SubmitJob(
+            [&release]() {
+              while (!release.load())
+                YieldThread();
+            },
+            JobPriority::Normal, COMPUTE_CAT);
+        JobDesc cancellable;
+        cancellable.Function = [&ran]() { ++ran; };
+        cancellable.Dependencies = &blocker;
+        cancellable.DependencyCount = 1;
+        cancellable.Cancellation = &token;
+        cancellable.Cat = COMPUTE_CAT;
+        const JobHandle dropped = SubmitJob(std::move(cancellable));
+        const JobHandle dependent = SubmitJob([&ran]() { ++ran; }, &dropped, 1,
+                                              JobPriority::Normal, COMPUTE_CAT);
+        const JobHandle grandchild =
+            SubmitJob([&ran]() { ++ran; }, &dependent, 1, JobPriority::Normal,
+                      COMPUTE_CAT);
+
+        token.Cancel();
+        release = true;
+        const JobHandle cancelledJobs[] = {blocker, dropped, dependent,
+                                           grandchild};
+        WaitForJobs(cancelledJobs, 4);
+        EXAMPLE_CHECK(ran.load() == 0);
+        EXAMPLE_CHECK(jobSystem.Stats().JobsCancelled - cancelledBefore == 3);
+      }
+
+      GECKO_INFO(MAIN_CAT, "Testing coroutine asset pipeline...");
+      const int loadedBytes = WaitForTask(LoadAssets(3));
+      GECKO_INFO(MAIN_CAT, "Coroutine pipeline loaded %d bytes", loadedBytes);
+
+      // Record a frame's work once, then replay it every frame
+      GECKO_INFO(MAIN_CAT, "Testing replayed job graph...");
+      JobGraph frameGraph("FrameGraph", SIMULATION_CAT);
+      const auto input = frameGraph.AddNode("Input", [] { SleepMs(2); });
+      const auto physics = frameGraph.AddNode("Physics", [] { SleepMs(6); });
+      const auto animation =
+          frameGraph.AddNode("Animation", [] { SleepMs(3); });
+      const auto render = frameGraph.AddNode("Render", [] { SleepMs(4); });
+      frameGraph.AddEdge(input, physics);
+      frameGraph.AddEdge(input, animation);
+      frameGraph.AddEdge(physics, render);
+      frameGraph.AddEdge(animation, render);
+      if (frameGraph.Compile()) {
+        for (int frame = 0; frame < 3; ++frame) {
+          frameGraph.Run();
+          frameGraph.Wait();
+          GECKO_INFO(MAIN_CAT, "Frame %d critical path: %.2f ms", frame,
+                     time::NsToMillisecondsF(frameGraph.CriticalPathNs()));
+        }
+      }
+
+      const u64 forkJoinSum = SumRange(0, 1000000);
+      EXAMPLE_CHECK(forkJoinSum == u64{999999} * 1000000 / 2);
+      GECKO_INFO(MAIN_CAT, "Fork-join sum of 0..1000000: %llu",
+                 static_cast<unsigned long long>(forkJoinSum));
+
+      // Children may fork more children into their own group; Wait and the
+      // group's handle both cover every one of them
+      {
+        std::atomic<int> finished{0};
+        JobGroup group;
+        for (int child = 0; child < 8; ++child) {
+          group.Run(
+              [&group, &finished]() {
+                group.Run([&finished]() { ++finished; }, JobPriority::Normal,
+                          COMPUTE_CAT);
+                ++finished;
+              },
+              JobPriority::Normal, COMPUTE_CAT);
+        }
+        const JobHandle joined = group.Handle();
+        int finishedBeforeJoin = -1;
+        JobHandle afterJoin =
+            SubmitJob([&finished, &finishedBeforeJoin]() {
+              finishedBeforeJoin = finished.load();
+            }, &joined, 1, JobPriority::Normal, COMPUTE_CAT);
+        group.Wait();
+        EXAMPLE_CHECK(group.IsComplete() && finished.load() == 16);
+        WaitForJob(afterJoin);
+        EXAMPLE_CHECK(finishedBeforeJoin == 16);
+      }
+
+      // Jobs that return values: the result stays in the job slot, or in a
+      // caller's buffer when it is too large, until the future lets go
+      GECKO_INFO(MAIN_CAT, "Testing job futures...");
+      {
+        std::atomic<bool> release{false};
+        JobFuture<int> gated = SubmitJob(
+            [&release]() {
+              while (!release.load())
+                YieldThread();
+              return 6;
+            },
+            JobPriority::Normal, COMPUTE_CAT);
+        EXAMPLE_CHECK(gated.IsValid() && gated.TryGet() == nullptr);
+        release = true;
+        EXAMPLE_CHECK(gated.Get() == 6);
+        EXAMPLE_CHECK(gated.TryGet() && *gated.TryGet() == 6);
+
+        JobFuture<u64> chained =
+            SubmitJob([]() { return 6; }, JobPriority::Normal, COMPUTE_CAT)
+                .Then([](int value) { return value * 7; })
+                .Then([](int value) { return static_cast<u64>(value) * 1000; });
+        EXAMPLE_CHECK(chained.Get() == 42000);
+
+        using Histogram = std::array<u64, 16>;
+        JobResultBuffer<Histogram> histogramBuffer;
+        JobDesc histogramDesc;
+        histogramDesc.Cat = COMPUTE_CAT;
+        JobFuture<Histogram> histogram =
+            SubmitJob(std::move(histogramDesc), histogramBuffer, []() {
+              Histogram counts{};
+              for (u32 i = 0; i < 1000; ++i)
+                ++counts[(i * 2654435761u) >> 28];
+              return counts;
+            });
+        const Histogram &counts = histogram.Get();
+        u64 counted = 0;
+        for (u64 count : counts)
+          counted += count;
+        const auto *bufferBegin =
+            static_cast<const unsigned char *>(histogramBuffer.Data());
+        const auto *valueBegin =
+            reinterpret_cast<const unsigned char *>(&counts);
+        EXAMPLE_CHECK(counted == 1000);
+        EXAMPLE_CHECK(valueBegin >= bufferBegin &&
+                      valueBegin < bufferBegin + sizeof(histogramBuffer));
+      }
+
+      // Stream items through a pipeline: every fifth item is dropped in the
+      // parallel stage, the rest come out in input order, and no more than
+      // `tokens` items are ever in flight. A second run reuses the object.
+      GECKO_INFO(MAIN_CAT, "Testing pipeline...");
+      {
+        constexpr u32 tokens = 4;
+        constexpr u64 itemCount = 200;
+        u64 slots[tokens] = {};
+        u64 produced = 0;
+        std::atomic<u32> inFlight{0};
+        std::atomic<u32> maxInFlight{0};
+        std::atomic<u32> inSerial{0};
+        bool serialOverlapped = false;
+        std::vector<u64> published;
+
+        Pipeline pipeline("Demo", COMPUTE_CAT);
+        pipeline.AddStage(PipelineMode::SerialInOrder,
+                          [&](PipelineItem &item) {
+                            if (produced == itemCount)
+                              return false;
+                            const u32 count = ++inFlight;
+                            if (count > maxInFlight.load())
+                              maxInFlight = count;
+                            slots[item.Token] = produced++;
+                            return true;
+                          });
+        pipeline.AddStage(PipelineMode::Parallel, [&](PipelineItem &item) {
+          SleepUs(item.Sequence % 3 == 0 ? 100 : 10);
+          if (item.Sequence % 5 == 0) {
+            --inFlight;
+            return false;
+          }
+          slots[item.Token] *= 2;
+          return true;
+        });
+        pipeline.AddStage(PipelineMode::SerialOutOfOrder,
+                          [&](PipelineItem &item) {
+                            if (++inSerial != 1)
+                              serialOverlapped = true;
+                            slots[item.Token] += 1;
+                            --inSerial;
+                            return true;
+                          });
+        pipeline.AddStage(PipelineMode::SerialInOrder,
+                          [&](PipelineItem &item) {
+                            published.push_back(slots[item.Token]);
+                            --inFlight;
+                            return true;
+                          });
+
+        for (int run = 0; run < 2; ++run) {
+          produced = 0;
+          published.clear();
+          EXAMPLE_CHECK(pipeline.Run(tokens));
+          pipeline.Wait();
+          EXAMPLE_CHECK(pipeline.IsComplete());
+
+          bool inOrder = published.size() == itemCount - itemCount / 5;
+          size_t next = 0;
+          for (u64 i = 0; i < itemCount && inOrder; ++i) {
+            if (i % 5 != 0)
+              inOrder = published[next++] == i * 2 + 1;
+          }
+          EXAMPLE_CHECK(inOrder);
+        }
+        EXAMPLE_CHECK(maxInFlight.load() <= tokens && inFlight.load() == 0);
+        EXAMPLE_CHECK(!serialOverlapped);
+        GECKO_INFO(MAIN_CAT, "Pipeline published %zu items per run",
+                   published.size());
+      }
+
       // Example of main thread job processing
       GECKO_INFO(MAIN_CAT, "Testing main thread job processing...");
       std::vector<JobHandle> mainThreadJobs;
@@ -583,6 +1164,12 @@ int main() {
   // Use GECKO_SHUTDOWN for proper cleanup
   GECKO_SHUTDOWN();
 
+  if (g_FailedChecks != 0) {
+    std::printf("\nDemo failed %d checks! Check the log output above.\n",
+                g_FailedChecks);
+    return 1;
+  }
+
   std::printf("\nDemo completed successfully! Check the log output above.\n");
   std::printf("The immediate logger writes all log messages directly without "
               "buffering.\n");
@@ -1,5 +1,6 @@
 #include <gecko/core/boot.h>
 #include <gecko/core/category.h>
+#include <gecko/core/jobs.h>
 #include <gecko/core/log.h>
 #include <gecko/core/profiler.h>
 #include <gecko/core/ptr.h>
@@ -15,6 +16,8 @@
 #include <gecko/runtime/trace_file_sink.h>
 #include <gecko/runtime/tracking_allocator.h>
 
+#include <cstdio>
+
 using namespace gecko;
 using namespace gecko::platform;
 
@@ -79,6 +82,12 @@ int main() {
     return 1;
   }
 
+  // Window calls are not thread-safe: workers hand them back to this thread,
+  // which runs them when it processes jobs each frame.
+  const JobThread mainThread = RegisterJobThread();
+  char title[64] = {};
+  JobHandle titleUpdate;
+
   bool running = true;
   // Avoid hanging forever in headless/Null-backend runs.
   // Run up to ~10 seconds unless a close is requested.
@@ -95,6 +104,16 @@ int main() {
       }
     }
 
+    if (frameCount % 60 == 0 && IsJobComplete(titleUpdate)) {
+      JobHandle format = SubmitJob([&title, frameCount]() {
+        std::snprintf(title, sizeof(title), "Gecko Platform Example - frame %u",
+                      frameCount);
+      });
+      titleUpdate = SubmitJob(
+          mainThread, [&]() { ctx->SetTitle(window, title); }, &format, 1);
+    }
+    jobSystem.ProcessJobs(8);
+
     GECKO_SLEEP_MS(16);
     ++frameCount;
   }
@@ -104,6 +123,7 @@ int main() {
     ctx->RequestClose(window);
   }
 
+  WaitForJob(titleUpdate);
   ctx->DestroyWindow(window);
 
   GECKO_SHUTDOWN();
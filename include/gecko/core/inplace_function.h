@@ -0,0 +1,178 @@
+#pragma once
+
+#include <concepts>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "assert.h"
+
+namespace gecko {
+
+// std::function replacement that stores the callable in an inline buffer of
+// `Capacity` bytes. Callables that are larger, over-aligned or whose move can
+// throw go on the heap instead; UsesHeap() reports it so hot paths can count
+// those allocations. Copying works when the callable is copyable.
+template <typename Signature, std::size_t Capacity = 64,
+          std::size_t Alignment = alignof(std::max_align_t)>
+class InplaceFunction;
+
+template <typename R, typename... Args, std::size_t Capacity,
+          std::size_t Alignment>
+class InplaceFunction<R(Args...), Capacity, Alignment> {
+  static_assert(Capacity >= sizeof(void *) && Alignment >= alignof(void *),
+                "InplaceFunction storage must be able to hold a pointer");
+
+  template <typename Fn>
+  static constexpr bool FitsInline =
+      sizeof(Fn) <= Capacity && alignof(Fn) <= Alignment &&
+      std::is_nothrow_move_constructible_v<Fn>;
+
+public:
+  static constexpr std::size_t StorageSize = Capacity;
+
+  InplaceFunction() noexcept = default;
+  InplaceFunction(std::nullptr_t) noexcept {}
+
+  template <typename F, typename Fn = std::decay_t<F>>
+    requires(!std::same_as<Fn, InplaceFunction> &&
+             std::is_invocable_r_v<R, Fn &, Args...>)
+  InplaceFunction(F &&function) noexcept(
+      FitsInline<Fn> && std::is_nothrow_constructible_v<Fn, F>) {
+    if constexpr (std::is_pointer_v<Fn>) {
+      if (function == nullptr)
+        return;
+    }
+
+    if constexpr (FitsInline<Fn>) {
+      ::new (static_cast<void *>(m_Storage)) Fn(std::forward<F>(function));
+      m_Ops = &InlineOps<Fn>;
+    } else {
+      HeapSlot<Fn>(m_Storage) = new Fn(std::forward<F>(function));
+      m_Ops = &HeapOps<Fn>;
+    }
+  }
+
+  InplaceFunction(InplaceFunction &&other) noexcept { MoveFrom(other); }
+
+  InplaceFunction(const InplaceFunction &other) { CopyFrom(other); }
+
+  InplaceFunction &operator=(InplaceFunction &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  InplaceFunction &operator=(const InplaceFunction &other) {
+    if (this != &other) {
+      InplaceFunction copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  InplaceFunction &operator=(std::nullptr_t) noexcept {
+    Reset();
+    return *this;
+  }
+
+  ~InplaceFunction() { Reset(); }
+
+  R operator()(Args... args) {
+    GECKO_ASSERT(m_Ops && "Calling an empty InplaceFunction");
+    return m_Ops->Invoke(m_Storage, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return m_Ops != nullptr; }
+
+  // True when the callable did not fit the inline buffer.
+  bool UsesHeap() const noexcept { return m_Ops && m_Ops->OnHeap; }
+
+  void Reset() noexcept {
+    if (m_Ops) {
+      m_Ops->Destroy(m_Storage);
+      m_Ops = nullptr;
+    }
+  }
+
+private:
+  struct Ops {
+    R (*Invoke)(void *storage, Args &&...args);
+    void (*Move)(void *destination, void *source) noexcept;
+    // Null when the callable is move-only.
+    void (*Copy)(void *destination, const void *source);
+    void (*Destroy)(void *storage) noexcept;
+    bool OnHeap;
+  };
+
+  template <typename Fn> static Fn *&HeapSlot(void *storage) noexcept {
+    return *static_cast<Fn **>(storage);
+  }
+
+  template <typename Fn, bool OnHeap>
+  static constexpr auto CopyFor() noexcept -> void (*)(void *, const void *) {
+    if constexpr (!std::is_copy_constructible_v<Fn>)
+      return nullptr;
+    else if constexpr (OnHeap)
+      return [](void *destination, const void *source) {
+        HeapSlot<Fn>(destination) =
+            new Fn(**static_cast<const Fn *const *>(source));
+      };
+    else
+      return [](void *destination, const void *source) {
+        ::new (destination) Fn(*static_cast<const Fn *>(source));
+      };
+  }
+
+  template <typename Fn>
+  static constexpr Ops InlineOps{
+      [](void *storage, Args &&...args) -> R {
+        return (*static_cast<Fn *>(storage))(std::forward<Args>(args)...);
+      },
+      [](void *destination, void *source) noexcept {
+        ::new (destination) Fn(std::move(*static_cast<Fn *>(source)));
+        static_cast<Fn *>(source)->~Fn();
+      },
+      CopyFor<Fn, false>(),
+      [](void *storage) noexcept { static_cast<Fn *>(storage)->~Fn(); },
+      false};
+
+  // The buffer holds only the pointer, so moving never touches the callable.
+  template <typename Fn>
+  static constexpr Ops HeapOps{
+      [](void *storage, Args &&...args) -> R {
+        return (*HeapSlot<Fn>(storage))(std::forward<Args>(args)...);
+      },
+      [](void *destination, void *source) noexcept {
+        HeapSlot<Fn>(destination) = HeapSlot<Fn>(source);
+      },
+      CopyFor<Fn, true>(),
+      [](void *storage) noexcept { delete HeapSlot<Fn>(storage); },
+      true};
+
+  void MoveFrom(InplaceFunction &other) noexcept {
+    if (other.m_Ops) {
+      other.m_Ops->Move(m_Storage, other.m_Storage);
+      m_Ops = other.m_Ops;
+      other.m_Ops = nullptr;
+    }
+  }
+
+  void CopyFrom(const InplaceFunction &other) {
+    if (other.m_Ops) {
+      GECKO_ASSERT(other.m_Ops->Copy &&
+                   "Copying an InplaceFunction that holds a move-only "
+                   "callable");
+      other.m_Ops->Copy(m_Storage, other.m_Storage);
+      m_Ops = other.m_Ops;
+    }
+  }
+
+  alignas(Alignment) unsigned char m_Storage[Capacity];
+  const Ops *m_Ops{nullptr};
+};
+
+} // namespace gecko
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "api.h"
+#include "category.h"
+#include "jobs.h"
+#include "types.h"
+
+namespace gecko {
+
+// A fixed set of jobs and dependencies that is recorded once and replayed
+// many times, e.g. every frame. Building and Compile() allocate; Run() only
+// resets precomputed counters and submits the root nodes, and each finished
+// node releases its successors directly.
+//
+// Every run also times its nodes. When the run finishes, the longest chain
+// of node durations (the critical path) is emitted to the profiler on its
+// own track, named after the graph, plus a counter with its total length.
+class JobGraph {
+public:
+  using NodeId = u32;
+  static constexpr NodeId InvalidNode = ~0u;
+
+  GECKO_API explicit JobGraph(const char *name = "JobGraph",
+                              Category category = Category{0}) noexcept;
+  GECKO_API ~JobGraph();
+
+  JobGraph(const JobGraph &) = delete;
+  JobGraph &operator=(const JobGraph &) = delete;
+
+  // Node functions are kept by the graph and invoked once per run. `name`
+  // must outlive the graph.
+  GECKO_API NodeId AddNode(const char *name, JobFunction function,
+                           JobPriority priority = JobPriority::Normal,
+                           Category category = Category{0}) noexcept;
+
+  // `after` runs only once `before` has finished. Returns false for unknown
+  // nodes or a self-edge.
+  GECKO_API bool AddEdge(NodeId before, NodeId after) noexcept;
+
+  // Validates the graph, sorts it topologically and precomputes successor
+  // lists and dependency counts. Returns false (and leaves the graph
+  // unrunnable) if the edges form a cycle. Adding nodes or edges afterwards
+  // requires compiling again.
+  GECKO_API bool Compile() noexcept;
+
+  // Starts a run. The graph must be compiled and not already running.
+  // Returns a handle that completes with the run, for IJobSystem::Wait or as
+  // a dependency of other jobs. It is invalid if the job system cannot hold
+  // jobs, in which case the run has already finished.
+  GECKO_API JobHandle Run() noexcept;
+
+  // Blocks until the current run has finished, running queued jobs on this
+  // thread in the meantime.
+  GECKO_API void Wait() noexcept;
+
+  GECKO_API bool IsComplete() const noexcept;
+  bool IsCompiled() const noexcept { return m_Compiled; }
+  u32 NodeCount() const noexcept { return static_cast<u32>(m_Nodes.size()); }
+
+  // Critical path length of the last finished run, in nanoseconds.
+  u64 CriticalPathNs() const noexcept { return m_CriticalPathNs; }
+
+private:
+  struct Node {
+    const char *Name{nullptr};
+    JobFunction Function;
+    JobPriority Priority{JobPriority::Normal};
+    Category Cat{};
+    u32 DependencyCount{0};
+    u32 FirstSuccessor{0};
+    u32 SuccessorCount{0};
+    u64 StartNs{0};
+    u64 EndNs{0};
+  };
+
+  void Launch(NodeId node) noexcept;
+  void RunNode(NodeId node) noexcept;
+  void FinishRun() noexcept;
+  void EmitCriticalPath() noexcept;
+
+  const char *m_Name{nullptr};
+  Category m_Category{};
+
+  std::vector<Node> m_Nodes;
+  std::vector<NodeId> m_EdgeFrom;
+  std::vector<NodeId> m_EdgeTo;
+
+  // Compiled form
+  std::vector<NodeId> m_Order;      // topological order
+  std::vector<NodeId> m_Successors; // flattened, indexed by FirstSuccessor
+  std::vector<NodeId> m_Roots;
+  std::unique_ptr<std::atomic<u32>[]> m_Pending;
+  bool m_Compiled{false};
+
+  // Critical path scratch, sized by Compile so runs never allocate
+  std::vector<u64> m_PathNs;
+  std::vector<NodeId> m_PathPrevious;
+  std::vector<NodeId> m_CriticalPath;
+  u64 m_CriticalPathNs{0};
+
+  std::atomic<u32> m_Remaining{0};
+  // Held job of the current run, released by FinishRun.
+  JobHandle m_Sink{};
+};
+
+} // namespace gecko
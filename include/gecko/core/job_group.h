@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
+#include "api.h"
+#include "category.h"
+#include "jobs.h"
+#include "types.h"
+
+namespace gecko {
+
+// Fork-join scope. Run() submits a child job into the group and children may
+// Run() more jobs into the same group, so recursive divide-and-conquer needs
+// one group per level instead of a handle per job. Wait() returns once every
+// child has finished, running queued jobs on the calling thread meanwhile,
+// and Handle() can be passed as a dependency like any other job.
+//
+// The count lives in a held job owned by the job system (see
+// IJobSystem::SubmitHeld), so the last child to finish never touches the
+// group itself. A group can be reused after Wait(); the destructor waits.
+//
+//   void Sum(const u32 *values, u32 count, u64 &out) {
+//     if (count <= 1024) {
+//       out = std::accumulate(values, values + count, u64{0});
+//       return;
+//     }
+//     u64 left = 0, right = 0;
+//     JobGroup group;
+//     group.Run([&] { Sum(values, count / 2, left); });
+//     Sum(values + count / 2, count - count / 2, right);
+//     group.Wait();
+//     out = left + right;
+//   }
+class JobGroup {
+public:
+  JobGroup() noexcept = default;
+  GECKO_API ~JobGroup();
+
+  JobGroup(const JobGroup &) = delete;
+  JobGroup &operator=(const JobGroup &) = delete;
+
+  // Submits `fn` as part of the group. Safe to call from any thread,
+  // including from the group's own children.
+  template <typename Fn>
+    requires std::invocable<std::decay_t<Fn> &>
+  void Run(Fn &&fn, JobPriority priority = JobPriority::Normal,
+           Category category = Category{0}) noexcept {
+    JobDesc desc;
+    desc.Function =
+        Child<std::decay_t<Fn>>(std::forward<Fn>(fn), AcquireGate());
+    desc.Priority = priority;
+    desc.Cat = category;
+    SubmitJob(std::move(desc));
+  }
+
+  // Waits for every job run in the group so far, helping with queued work.
+  GECKO_API void Wait() noexcept;
+
+  // Finishes once every job run in the group so far has finished. Invalid
+  // (already satisfied) when nothing is running.
+  GECKO_API JobHandle Handle() const noexcept;
+
+  GECKO_API bool IsComplete() const noexcept;
+
+private:
+  // Releases its hold on the gate when destroyed, which the job system does
+  // after the job ran or when it drops the job, so a child that never runs
+  // still finishes the group.
+  template <typename Fn> struct Child {
+    Fn Function;
+    JobHandle Gate;
+
+    template <typename F>
+    Child(F &&function, JobHandle gate) noexcept
+        : Function(std::forward<F>(function)), Gate(gate) {}
+    Child(Child &&other) noexcept
+        : Function(std::move(other.Function)),
+          Gate(std::exchange(other.Gate, JobHandle{})) {}
+    Child &operator=(Child &&) = delete;
+    ~Child() { ReleaseGate(Gate); }
+
+    void operator()() { Function(); }
+  };
+
+  // Returns the current gate with a hold added for one more child, starting
+  // a new gate if the last one already finished.
+  GECKO_API JobHandle AcquireGate() noexcept;
+  GECKO_API static void ReleaseGate(JobHandle gate) noexcept;
+
+  std::atomic<JobHandle> m_Gate{};
+};
+
+} // namespace gecko
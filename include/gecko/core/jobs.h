@@ -1,14 +1,43 @@
 #pragma once
 
+#include <atomic>
+#include <concepts>
+#include <cstddef>
 #include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <ranges>
+#include <type_traits>
+#include <utility>
 
 #include "api.h"
+#include "assert.h"
+#include "bit.h"
 #include "category.h"
+#include "inplace_function.h"
+#include "optional.h"
+#include "time.h"
 #include "types.h"
 
+// Bytes of captured state a job can carry without touching the heap; larger
+// captures fall back to a heap allocation
+#ifndef GECKO_JOB_FUNCTION_CAPACITY
+#define GECKO_JOB_FUNCTION_CAPACITY 64
+#endif
+
+// Bytes of result a job slot can hold for a JobFuture; larger results go in
+// a caller-provided JobResultBuffer
+#ifndef GECKO_JOB_RESULT_CAPACITY
+#define GECKO_JOB_RESULT_CAPACITY 32
+#endif
+
 namespace gecko {
 
-using JobFunction = std::function<void()>;
+using JobFunction = InplaceFunction<void(), GECKO_JOB_FUNCTION_CAPACITY>;
+
+inline constexpr u32 JobResultCapacity = GECKO_JOB_RESULT_CAPACITY;
+inline constexpr u32 JobResultAlignment = alignof(std::max_align_t);
 
 struct JobHandle {
   u64 Id{0};
@@ -29,9 +58,130 @@ struct JobHandle {
 
 enum class JobPriority : u8 { Low, Normal, High };
 
+// Which set of worker threads runs a job. Job systems without separate
+// groups, or a group configured without threads, run it with Compute.
+enum class WorkerGroup : u8 {
+  Default,  // Routed by category, otherwise Compute
+  Compute,  // Frame and throughput work
+  Io,       // Work that blocks on files, sockets or the OS
+  Realtime, // Latency-critical work that must not queue behind Compute
+};
+
+enum class JobFlags : u8 {
+  None = 0,
+  // The job spends most of its time blocked (I/O, sleeping, locks). The pool
+  // may run a compensating thread while it blocks.
+  Blocking = Bit(0),
+  // The job is shorter than a trip through the queues. If it is ready when
+  // submitted, the submitting thread may run it in place.
+  Cheap = Bit(1),
+};
+
+// A thread registered with IJobSystem::RegisterThread. Jobs targeted at it
+// (JobDesc::Thread) run only on that thread, when it calls ProcessJobs or
+// waits on a job, for work that is not thread-safe such as window system
+// calls.
+struct JobThread {
+  u32 Id{0};
+
+  bool IsValid() const noexcept { return Id != 0; }
+
+  bool operator==(const JobThread &other) const noexcept {
+    return Id == other.Id;
+  }
+  bool operator!=(const JobThread &other) const noexcept {
+    return Id != other.Id;
+  }
+};
+
+// A job that re-runs at a fixed period, see IJobSystem::SubmitPeriodic.
+struct PeriodicJob {
+  u64 Id{0};
+
+  bool IsValid() const noexcept { return Id != 0; }
+
+  bool operator==(const PeriodicJob &other) const noexcept {
+    return Id == other.Id;
+  }
+  bool operator!=(const PeriodicJob &other) const noexcept {
+    return Id != other.Id;
+  }
+};
+
+// Cooperative cancellation for a set of jobs, attached through
+// JobDesc::Cancellation. Jobs that have not started when it is cancelled are
+// dropped without running, and so is everything that depends on them; a
+// running job stops early only if it polls the token itself. The owner keeps
+// the token alive until every job it was attached to has finished.
+class CancellationToken {
+public:
+  CancellationToken() noexcept = default;
+  CancellationToken(const CancellationToken &) = delete;
+  CancellationToken &operator=(const CancellationToken &) = delete;
+
+  void Cancel() noexcept { m_Cancelled.store(true, std::memory_order_release); }
+
+  // Re-arms the token once the jobs it was attached to have finished.
+  void Reset() noexcept { m_Cancelled.store(false, std::memory_order_release); }
+
+  bool IsCancelled() const noexcept {
+    return m_Cancelled.load(std::memory_order_acquire);
+  }
+
+private:
+  std::atomic<bool> m_Cancelled{false};
+};
+
+// One entry of a SubmitBatch call. The function is moved out on submit.
+// Dependencies may point into the batch's output handle array for entries
+// earlier in the same batch, since handles are written in order.
+struct JobDesc {
+  JobFunction Function;
+  const JobHandle *Dependencies{nullptr};
+  u32 DependencyCount{0};
+  JobPriority Priority{JobPriority::Normal};
+  Category Cat{};
+  WorkerGroup Group{WorkerGroup::Default};
+  JobFlags Flags{JobFlags::None};
+  // Optional; not owned.
+  const CancellationToken *Cancellation{nullptr};
+  // Resources the job reads and writes, as opaque ids such as FNV1a of a
+  // name. The job is ordered after earlier jobs it conflicts with: a reader
+  // after the last writer, a writer after the last writer and every reader
+  // since. Readers of the same resource run concurrently. The inferred
+  // dependencies behave like explicit ones, cancellation included. Only read
+  // during submission; periodic jobs ignore them.
+  const u64 *Reads{nullptr};
+  u32 ReadCount{0};
+  const u64 *Writes{nullptr};
+  u32 WriteCount{0};
+  // Runs the job on a registered thread instead of a worker; Group and Flags
+  // are then ignored.
+  JobThread Thread{};
+};
+
+// Where a job's result lives, see IJobSystem::SubmitWithResult. Filled in by
+// JobFuture.
+struct JobResultDesc {
+  u32 Size{0};
+  u32 Alignment{0};
+  // Caller-owned storage, or null to keep the result in the job slot.
+  void *Buffer{nullptr};
+  // Constructs an empty result in `storage` and returns the job function that
+  // fills it in. Called once, before the job can run.
+  JobFunction (*Bind)(void *context, void *storage) noexcept {nullptr};
+  void *Context{nullptr};
+  // Destroys the result once it has been released and the job has finished.
+  void (*Destroy)(void *storage) noexcept {nullptr};
+};
+
 struct IJobSystem {
   GECKO_API virtual ~IJobSystem() = default;
 
+  // Queues a job, or runs it on the calling thread before returning: a
+  // ready job may run in place when the queue it would join is deep or it is
+  // marked Cheap (see WorkerInlinePolicy). Do not submit while holding a lock
+  // the job takes; the same goes for SubmitBatch and the SubmitJob helpers.
   GECKO_API virtual JobHandle
   Submit(JobFunction job, JobPriority priority = JobPriority::Normal,
          Category category = Category{0}) noexcept = 0;
@@ -41,6 +191,60 @@ struct IJobSystem {
          JobPriority priority = JobPriority::Normal,
          Category category = Category{0}) noexcept = 0;
 
+  // Submits `count` jobs at once and wakes only as many workers as there are
+  // newly runnable jobs. `outHandles` may be null; otherwise it receives one
+  // handle per job, invalid for jobs that could not be submitted.
+  GECKO_API virtual void SubmitBatch(JobDesc *jobs, u32 count,
+                                     JobHandle *outHandles) noexcept = 0;
+
+  // Submits one job that becomes runnable once its dependencies are done
+  // and MonotonicTimeNs() has reached `deadlineNs`. Until then it holds a job
+  // slot, and its handle can be waited on and depended on as usual. The null
+  // job system does not honour deadlines: it runs the job in place at once.
+  GECKO_API virtual JobHandle SubmitAt(JobDesc desc,
+                                       u64 deadlineNs) noexcept = 0;
+
+  // Runs desc.Function every `periodNs`, starting one period from now, until
+  // CancelPeriodic. Runs never overlap. If a run overruns, the periods it
+  // missed are skipped rather than run back to back. Dependencies and
+  // Cancellation are ignored. Returns an invalid PeriodicJob if the job
+  // system has no timer or no free periodic slot.
+  GECKO_API virtual PeriodicJob SubmitPeriodic(JobDesc desc,
+                                               u64 periodNs) noexcept = 0;
+
+  // Stops a periodic job. If a run has already started, this returns once
+  // it has finished, so the function's captures can be released afterwards.
+  // Must not be called from the periodic job itself.
+  GECKO_API virtual void CancelPeriodic(PeriodicJob job) noexcept = 0;
+
+  // Submits a job that, besides its dependencies, waits until every hold on
+  // it has been released. It starts with one hold. desc.Function may be
+  // empty for a job that only marks a point others can depend on, as
+  // JobGroup does. Returns an invalid handle, after running desc.Function
+  // in place, if the job system cannot hold jobs.
+  GECKO_API virtual JobHandle SubmitHeld(JobDesc desc) noexcept = 0;
+
+  // Adds a hold to a job from SubmitHeld. Fails once the job has become
+  // runnable; a held job cannot.
+  GECKO_API virtual bool AddHold(JobHandle handle) noexcept = 0;
+
+  // Releases one hold; the caller must own it.
+  GECKO_API virtual void ReleaseHold(JobHandle handle) noexcept = 0;
+
+  // Submits a job whose function comes from result.Bind (desc.Function is
+  // ignored) and writes a result that outlives the job. `outStorage`
+  // receives where the result lives; it stays valid, and a slot-stored
+  // result keeps its job slot, until ReleaseResult.
+  GECKO_API virtual JobHandle SubmitWithResult(JobDesc desc,
+                                               const JobResultDesc &result,
+                                               void *&outStorage) noexcept = 0;
+
+  // Gives up a result from SubmitWithResult. It is destroyed now, or when
+  // the job finishes if it is still pending.
+  GECKO_API virtual void
+  ReleaseResult(JobHandle handle, void *storage,
+                const JobResultDesc &result) noexcept = 0;
+
   GECKO_API virtual void Wait(JobHandle handle) noexcept = 0;
 
   GECKO_API virtual void WaitAll(const JobHandle *handles,
@@ -50,14 +254,23 @@ struct IJobSystem {
 
   GECKO_API virtual u32 WorkerThreadCount() const noexcept = 0;
 
+  // Runs up to `maxJobs` queued jobs on the calling thread, starting with
+  // the ones targeted at it if it is a registered thread.
   GECKO_API virtual void ProcessJobs(u32 maxJobs = 1) noexcept = 0;
 
+  // Makes the calling thread a target for JobDesc::Thread until Shutdown.
+  // Registering again returns the same JobThread. Returns an invalid one if
+  // the job system cannot target threads, in which case such jobs run like
+  // any other.
+  GECKO_API virtual JobThread RegisterThread() noexcept = 0;
+
   GECKO_API virtual bool Init() noexcept = 0;
   GECKO_API virtual void Shutdown() noexcept = 0;
 };
 
 GECKO_API IJobSystem *GetJobSystem() noexcept;
 
+// May run the job before returning, see IJobSystem::Submit.
 GECKO_API inline JobHandle SubmitJob(JobFunction job,
                                      JobPriority priority = JobPriority::Normal,
                                      Category category = Category{0}) noexcept {
@@ -77,6 +290,95 @@ GECKO_API inline JobHandle SubmitJob(JobFunction job,
   return JobHandle{};
 }
 
+GECKO_API inline void SubmitJobs(JobDesc *jobs, u32 count,
+                                 JobHandle *outHandles = nullptr) noexcept {
+  if (auto *jobSystem = GetJobSystem()) {
+    jobSystem->SubmitBatch(jobs, count, outHandles);
+  } else if (outHandles) {
+    for (u32 i = 0; i < count; ++i)
+      outHandles[i] = JobHandle{};
+  }
+}
+
+// Single-job form of SubmitJobs, for the options only JobDesc carries (worker
+// group, flags, cancellation, target thread).
+GECKO_API inline JobHandle SubmitJob(JobDesc desc) noexcept {
+  JobHandle handle;
+  SubmitJobs(&desc, 1, &handle);
+  return handle;
+}
+
+GECKO_API inline JobThread RegisterJobThread() noexcept {
+  if (auto *jobSystem = GetJobSystem())
+    return jobSystem->RegisterThread();
+  return JobThread{};
+}
+
+// Runs `job` on `thread` once its dependencies, which may be any jobs, are
+// done.
+GECKO_API inline JobHandle SubmitJob(JobThread thread, JobFunction job,
+                                     const JobHandle *dependencies = nullptr,
+                                     u32 dependencyCount = 0,
+                                     JobPriority priority = JobPriority::Normal,
+                                     Category category = Category{0}) noexcept {
+  JobDesc desc;
+  desc.Function = std::move(job);
+  desc.Dependencies = dependencies;
+  desc.DependencyCount = dependencyCount;
+  desc.Priority = priority;
+  desc.Cat = category;
+  desc.Thread = thread;
+  return SubmitJob(std::move(desc));
+}
+
+GECKO_API inline JobHandle SubmitJobAt(JobDesc desc, u64 deadlineNs) noexcept {
+  if (auto *jobSystem = GetJobSystem())
+    return jobSystem->SubmitAt(std::move(desc), deadlineNs);
+  return JobHandle{};
+}
+
+GECKO_API inline JobHandle
+SubmitJobAt(JobFunction job, u64 deadlineNs,
+            JobPriority priority = JobPriority::Normal,
+            Category category = Category{0}) noexcept {
+  JobDesc desc;
+  desc.Function = std::move(job);
+  desc.Priority = priority;
+  desc.Cat = category;
+  return SubmitJobAt(std::move(desc), deadlineNs);
+}
+
+GECKO_API inline JobHandle
+SubmitJobAfter(JobFunction job, u64 delayNs,
+               JobPriority priority = JobPriority::Normal,
+               Category category = Category{0}) noexcept {
+  return SubmitJobAt(std::move(job), MonotonicTimeNs() + delayNs, priority,
+                     category);
+}
+
+GECKO_API inline PeriodicJob SubmitPeriodicJob(JobDesc desc,
+                                               u64 periodNs) noexcept {
+  if (auto *jobSystem = GetJobSystem())
+    return jobSystem->SubmitPeriodic(std::move(desc), periodNs);
+  return PeriodicJob{};
+}
+
+GECKO_API inline PeriodicJob
+SubmitPeriodicJob(JobFunction job, u64 periodNs,
+                  JobPriority priority = JobPriority::Normal,
+                  Category category = Category{0}) noexcept {
+  JobDesc desc;
+  desc.Function = std::move(job);
+  desc.Priority = priority;
+  desc.Cat = category;
+  return SubmitPeriodicJob(std::move(desc), periodNs);
+}
+
+GECKO_API inline void CancelPeriodicJob(PeriodicJob job) noexcept {
+  if (auto *jobSystem = GetJobSystem())
+    jobSystem->CancelPeriodic(job);
+}
+
 GECKO_API inline void WaitForJob(JobHandle handle) noexcept {
   if (auto *jobSystem = GetJobSystem())
     jobSystem->Wait(handle);
@@ -94,4 +396,293 @@ GECKO_API inline bool IsJobComplete(JobHandle handle) noexcept {
   return true;
 }
 
+template <typename T> class JobFuture;
+
+// Caller-owned storage for a JobFuture<T> result too large for a job slot.
+// It must stay put and outlive the future.
+template <typename T> class JobResultBuffer {
+public:
+  JobResultBuffer() noexcept = default;
+  JobResultBuffer(const JobResultBuffer &) = delete;
+  JobResultBuffer &operator=(const JobResultBuffer &) = delete;
+
+  void *Data() noexcept { return m_Storage; }
+
+private:
+  alignas(Optional<T>) unsigned char m_Storage[sizeof(Optional<T>)];
+};
+
+namespace detail {
+
+template <typename T>
+inline constexpr bool FitsJobSlot = sizeof(Optional<T>) <= JobResultCapacity &&
+                                    alignof(Optional<T>) <= JobResultAlignment;
+
+template <typename T>
+inline JobResultDesc MakeJobResultDesc(void *buffer) noexcept {
+  JobResultDesc result;
+  result.Size = sizeof(Optional<T>);
+  result.Alignment = alignof(Optional<T>);
+  result.Buffer = buffer;
+  result.Destroy = [](void *storage) noexcept {
+    static_cast<Optional<T> *>(storage)->~Optional<T>();
+  };
+  return result;
+}
+
+// Submits `fill`, called as fill(Optional<T> &), as a job with its result
+// stored in `buffer` or the job slot.
+template <typename T, typename Fill>
+inline JobFuture<T> SubmitFuture(JobDesc desc, void *buffer,
+                                 Fill fill) noexcept {
+  auto *jobSystem = GetJobSystem();
+  if (!jobSystem)
+    return JobFuture<T>{};
+
+  JobResultDesc result = MakeJobResultDesc<T>(buffer);
+  result.Context = std::addressof(fill);
+  result.Bind = [](void *context, void *storage) noexcept -> JobFunction {
+    Optional<T> *value = ::new (storage) Optional<T>();
+    return [fill = std::move(*static_cast<Fill *>(context)),
+            value]() mutable { fill(*value); };
+  };
+
+  void *storage = nullptr;
+  const JobHandle handle =
+      jobSystem->SubmitWithResult(std::move(desc), result, storage);
+  return JobFuture<T>(handle, static_cast<Optional<T> *>(storage),
+                      buffer != nullptr);
+}
+
+template <typename T, typename Fn>
+inline JobFuture<T> SubmitValueJob(JobDesc desc, void *buffer,
+                                   Fn fn) noexcept {
+  return SubmitFuture<T>(std::move(desc), buffer,
+                         [fn = std::move(fn)](Optional<T> &out) mutable {
+                           out.emplace(std::invoke(fn));
+                         });
+}
+
+} // namespace detail
+
+// The value a job returns. It lives in the job's pool slot (or a caller's
+// JobResultBuffer), which the future keeps until it is destroyed, so no
+// result ever touches the heap; live futures count against the job system's
+// capacity. A job that is cancelled or throws leaves no value. The future
+// can be waited on and depended on through Handle().
+//
+//   JobFuture<u32> count = SubmitJob([&] { return CountVisible(scene); });
+//   JobFuture<Batch> batch = std::move(count).Then([](u32 n) {
+//     return BuildBatch(n);
+//   });
+//   Draw(batch.Get());
+template <typename T> class JobFuture {
+  static_assert(!std::is_void_v<T> && !std::is_reference_v<T>,
+                "JobFuture holds a value; submit void jobs with SubmitJob");
+
+public:
+  JobFuture() noexcept = default;
+  JobFuture(JobHandle handle, Optional<T> *value, bool external) noexcept
+      : m_Handle(handle), m_Value(value), m_External(external) {}
+
+  JobFuture(JobFuture &&other) noexcept
+      : m_Handle(std::exchange(other.m_Handle, JobHandle{})),
+        m_Value(std::exchange(other.m_Value, nullptr)),
+        m_External(other.m_External) {}
+
+  JobFuture &operator=(JobFuture &&other) noexcept {
+    if (this != &other) {
+      Reset();
+      m_Handle = std::exchange(other.m_Handle, JobHandle{});
+      m_Value = std::exchange(other.m_Value, nullptr);
+      m_External = other.m_External;
+    }
+    return *this;
+  }
+
+  JobFuture(const JobFuture &) = delete;
+  JobFuture &operator=(const JobFuture &) = delete;
+
+  // Releasing a pending future does not wait; the job still runs and its
+  // value is dropped.
+  ~JobFuture() { Reset(); }
+
+  bool IsValid() const noexcept { return m_Value != nullptr; }
+  JobHandle Handle() const noexcept { return m_Handle; }
+  bool IsComplete() const noexcept { return IsJobComplete(m_Handle); }
+
+  // Waits for the job (helping with other work meanwhile) and returns its
+  // value. The job must not have been cancelled or have thrown.
+  T &Get() noexcept {
+    GECKO_ASSERT(IsValid() && "Get on an empty JobFuture");
+    WaitForJob(m_Handle);
+    GECKO_ASSERT(m_Value->has_value() && "Job finished without a result");
+    return **m_Value;
+  }
+
+  // The value if the job has finished with one, null otherwise.
+  T *TryGet() noexcept {
+    if (!m_Value || !IsJobComplete(m_Handle) || !m_Value->has_value())
+      return nullptr;
+    return std::addressof(**m_Value);
+  }
+
+  // Runs `fn` on the value as a job once this one finishes, taking over the
+  // future. If this job leaves no value, neither does the continuation.
+  template <typename Fn>
+    requires std::invocable<Fn &, T &&>
+  JobFuture<std::invoke_result_t<Fn &, T &&>>
+  Then(Fn fn, JobPriority priority = JobPriority::Normal,
+       Category category = Category{0}) && noexcept {
+    using U = std::invoke_result_t<Fn &, T &&>;
+    static_assert(detail::FitsJobSlot<U>,
+                  "Continuation result does not fit in a job slot");
+
+    // The future moves into the continuation while it is submitted.
+    const JobHandle dependency = m_Handle;
+    JobDesc desc;
+    desc.Dependencies = &dependency;
+    desc.DependencyCount = 1;
+    desc.Priority = priority;
+    desc.Cat = category;
+    return detail::SubmitFuture<U>(
+        std::move(desc), nullptr,
+        [source = std::move(*this), fn = std::move(fn)](
+            Optional<U> &out) mutable {
+          if (T *value = source.TryGet())
+            out.emplace(std::invoke(fn, std::move(*value)));
+        });
+  }
+
+  // Releases the result; see the destructor.
+  void Reset() noexcept {
+    if (!m_Value)
+      return;
+    if (auto *jobSystem = GetJobSystem()) {
+      jobSystem->ReleaseResult(
+          m_Handle, m_Value,
+          detail::MakeJobResultDesc<T>(m_External ? m_Value : nullptr));
+    }
+    m_Handle.Reset();
+    m_Value = nullptr;
+  }
+
+private:
+  JobHandle m_Handle;
+  Optional<T> *m_Value{nullptr};
+  bool m_External{false};
+};
+
+template <typename Fn>
+using JobResultOf = std::invoke_result_t<Fn &>;
+
+// Runs `fn` as a job and keeps what it returns in the job slot.
+template <typename Fn>
+  requires std::invocable<Fn &> && (!std::is_void_v<JobResultOf<Fn>>)
+inline JobFuture<JobResultOf<Fn>>
+SubmitJob(Fn fn, JobPriority priority = JobPriority::Normal,
+          Category category = Category{0}) noexcept {
+  static_assert(detail::FitsJobSlot<JobResultOf<Fn>>,
+                "Result does not fit in a job slot; pass a JobResultBuffer");
+  JobDesc desc;
+  desc.Priority = priority;
+  desc.Cat = category;
+  return detail::SubmitValueJob<JobResultOf<Fn>>(std::move(desc), nullptr,
+                                                 std::move(fn));
+}
+
+template <typename Fn>
+  requires std::invocable<Fn &> && (!std::is_void_v<JobResultOf<Fn>>)
+inline JobFuture<JobResultOf<Fn>>
+SubmitJob(Fn fn, const JobHandle *dependencies, u32 dependencyCount,
+          JobPriority priority = JobPriority::Normal,
+          Category category = Category{0}) noexcept {
+  static_assert(detail::FitsJobSlot<JobResultOf<Fn>>,
+                "Result does not fit in a job slot; pass a JobResultBuffer");
+  JobDesc desc;
+  desc.Dependencies = dependencies;
+  desc.DependencyCount = dependencyCount;
+  desc.Priority = priority;
+  desc.Cat = category;
+  return detail::SubmitValueJob<JobResultOf<Fn>>(std::move(desc), nullptr,
+                                                 std::move(fn));
+}
+
+// JobDesc form; desc.Function is ignored.
+template <typename Fn>
+  requires std::invocable<Fn &> && (!std::is_void_v<JobResultOf<Fn>>)
+inline JobFuture<JobResultOf<Fn>> SubmitJob(JobDesc desc, Fn fn) noexcept {
+  static_assert(detail::FitsJobSlot<JobResultOf<Fn>>,
+                "Result does not fit in a job slot; pass a JobResultBuffer");
+  return detail::SubmitValueJob<JobResultOf<Fn>>(std::move(desc), nullptr,
+                                                 std::move(fn));
+}
+
+// Keeps the result in `buffer` instead of the job slot, for any size.
+template <typename Fn>
+  requires std::invocable<Fn &> && (!std::is_void_v<JobResultOf<Fn>>)
+inline JobFuture<JobResultOf<Fn>>
+SubmitJob(JobDesc desc, JobResultBuffer<JobResultOf<Fn>> &buffer,
+          Fn fn) noexcept {
+  return detail::SubmitValueJob<JobResultOf<Fn>>(std::move(desc),
+                                                 buffer.Data(), std::move(fn));
+}
+
+// Pass as `grain` to let ParallelFor size chunks from measured per-iteration
+// cost instead of a fixed count.
+inline constexpr u64 AutoGrain = 0;
+
+// Type-erased loop body: runs iterations [begin, end).
+using ParallelForBody = void (*)(void *context, u64 begin, u64 end);
+
+// Runs `body` over [begin, end) on the job system and returns once every
+// iteration has run. The range is split in halves down to `grain` iterations;
+// the calling thread works on the front half and helps with queued jobs while
+// idle workers steal the larger pieces. Runs inline on a job system without
+// worker threads.
+GECKO_API void ParallelForRange(u64 begin, u64 end, u64 grain,
+                                ParallelForBody body, void *context,
+                                JobPriority priority = JobPriority::Normal,
+                                Category category = Category{0}) noexcept;
+
+template <typename Fn>
+  requires std::invocable<Fn &, u64>
+inline void ParallelFor(u64 begin, u64 end, u64 grain, Fn &&fn,
+                        JobPriority priority = JobPriority::Normal,
+                        Category category = Category{0}) noexcept {
+  using Body = std::remove_reference_t<Fn>;
+  ParallelForRange(
+      begin, end, grain,
+      [](void *context, u64 first, u64 last) {
+        Body &body = *static_cast<Body *>(context);
+        for (u64 i = first; i < last; ++i)
+          body(i);
+      },
+      const_cast<void *>(static_cast<const void *>(std::addressof(fn))),
+      priority, category);
+}
+
+template <std::random_access_iterator It, typename Fn>
+  requires std::invocable<Fn &, std::iter_reference_t<It>>
+inline void ParallelForEach(It first, It last, u64 grain, Fn &&fn,
+                            JobPriority priority = JobPriority::Normal,
+                            Category category = Category{0}) noexcept {
+  ParallelFor(
+      0, static_cast<u64>(last - first), grain,
+      [first, &fn](u64 i) {
+        fn(first[static_cast<std::iter_difference_t<It>>(i)]);
+      },
+      priority, category);
+}
+
+template <std::ranges::random_access_range Range, typename Fn>
+  requires std::invocable<Fn &, std::ranges::range_reference_t<Range>>
+inline void ParallelForEach(Range &&range, u64 grain, Fn &&fn,
+                            JobPriority priority = JobPriority::Normal,
+                            Category category = Category{0}) noexcept {
+  auto first = std::ranges::begin(range);
+  ParallelForEach(first, first + std::ranges::distance(range), grain, fn,
+                  priority, category);
+}
+
 } // namespace gecko
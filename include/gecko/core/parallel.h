@@ -0,0 +1,696 @@
+#pragma once
+
+#include <algorithm>
+#include <concepts>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "category.h"
+#include "jobs.h"
+#include "memory.h"
+#include "profiler.h"
+#include "types.h"
+
+// Parallel algorithms on top of the job system. Input is split into a few
+// blocks per worker, none smaller than ParallelMinBlockSize elements, and the
+// blocks run as ParallelFor jobs; the calling thread joins in. With no job
+// system or no workers the same code runs serially on the calling thread.
+// Scratch memory comes from the installed allocator under the caller's
+// category; if it cannot be had, the algorithm runs serially without it.
+// Functors are called concurrently and must not throw.
+
+namespace gecko {
+
+// Smallest block worth handing to another thread.
+inline constexpr u64 ParallelMinBlockSize = 4096;
+
+namespace detail {
+
+// 1 when there is nobody to share the work with.
+inline u64 ParallelBlockCount(u64 count) noexcept {
+  IJobSystem *jobSystem = GetJobSystem();
+  const u64 workers = jobSystem ? jobSystem->WorkerThreadCount() : 0;
+  if (workers == 0 || count <= ParallelMinBlockSize)
+    return 1;
+
+  // A few blocks per thread (workers plus the caller) evens out blocks that
+  // cost more than others.
+  const u64 maxBlocks = (workers + 1) * 4;
+  return std::min(maxBlocks,
+                  (count + ParallelMinBlockSize - 1) / ParallelMinBlockSize);
+}
+
+// Start of block `block` when `count` elements are split into `blocks`
+// near-equal pieces; block `blocks` is the end.
+inline u64 BlockBegin(u64 count, u64 blocks, u64 block) noexcept {
+  return (count / blocks) * block + std::min(block, count % blocks);
+}
+
+template <typename Fn>
+void ForEachBlock(u64 blocks, Fn &&fn, Category category) noexcept {
+  ParallelFor(0, blocks, 1, fn, JobPriority::Normal, category);
+}
+
+template <std::random_access_iterator It>
+decltype(auto) At(It first, u64 index) noexcept {
+  return first[static_cast<std::iter_difference_t<It>>(index)];
+}
+
+// Uninitialized storage for `count` Ts from the installed allocator.
+template <typename T> class ScratchBuffer {
+public:
+  ScratchBuffer(u64 count, Category category) noexcept
+      : m_Count(count), m_Category(category) {
+    if (count > 0)
+      m_Data = AllocArray<T>(count, category);
+  }
+
+  ~ScratchBuffer() {
+    if (m_Data)
+      DeallocBytes(m_Data, sizeof(T) * m_Count, alignof(T), m_Category);
+  }
+
+  ScratchBuffer(const ScratchBuffer &) = delete;
+  ScratchBuffer &operator=(const ScratchBuffer &) = delete;
+
+  explicit operator bool() const noexcept { return m_Data != nullptr; }
+  T *Data() const noexcept { return m_Data; }
+  T &operator[](u64 index) const noexcept { return m_Data[index]; }
+
+private:
+  T *m_Data{nullptr};
+  u64 m_Count{0};
+  Category m_Category{};
+};
+
+// Moves the stable merge of [a, a + countA) and [b, b + countB) to `out`.
+template <typename A, typename B, typename Out, typename Compare>
+void MoveMerge(A a, u64 countA, B b, u64 countB, Out out,
+               Compare &comp) noexcept {
+  u64 i = 0;
+  u64 j = 0;
+  u64 k = 0;
+  while (i < countA && j < countB) {
+    // Ties go to `a`, which keeps the merge stable
+    if (comp(At(b, j), At(a, i)))
+      At(out, k++) = std::move(At(b, j++));
+    else
+      At(out, k++) = std::move(At(a, i++));
+  }
+  for (; i < countA; ++i)
+    At(out, k++) = std::move(At(a, i));
+  for (; j < countB; ++j)
+    At(out, k++) = std::move(At(b, j));
+}
+
+// How many of the first `diagonal` elements of the stable merge of `a` and
+// `b` come from `a` (merge path). Lets several threads merge disjoint slices
+// of one output.
+template <typename A, typename B, typename Compare>
+u64 MergeSplit(A a, u64 countA, B b, u64 countB, u64 diagonal,
+               Compare &comp) noexcept {
+  u64 low = diagonal > countB ? diagonal - countB : 0;
+  u64 high = std::min(diagonal, countA);
+  while (low < high) {
+    const u64 mid = low + (high - low) / 2;
+    if (!comp(At(b, diagonal - mid - 1), At(a, mid)))
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  return low;
+}
+
+// Stable merge sort of `count` elements, using `scratch` (same size, holding
+// live objects) as the other buffer. The result ends up in `data`.
+template <typename Data, typename Scratch, typename Compare>
+void SerialMergeSort(Data data, Scratch scratch, u64 count,
+                     Compare &comp) noexcept {
+  // Insertion-sort short runs, then merge them pairwise
+  constexpr u64 RunLength = 32;
+  for (u64 run = 0; run < count; run += RunLength) {
+    const u64 end = std::min(run + RunLength, count);
+    for (u64 i = run + 1; i < end; ++i) {
+      if (!comp(At(data, i), At(data, i - 1)))
+        continue;
+      auto value = std::move(At(data, i));
+      u64 j = i;
+      do {
+        At(data, j) = std::move(At(data, j - 1));
+        --j;
+      } while (j > run && comp(value, At(data, j - 1)));
+      At(data, j) = std::move(value);
+    }
+  }
+
+  bool inData = true;
+  for (u64 width = RunLength; width < count; width *= 2) {
+    for (u64 begin = 0; begin < count; begin += 2 * width) {
+      const u64 middle = std::min(begin + width, count);
+      const u64 end = std::min(begin + 2 * width, count);
+      if (inData)
+        MoveMerge(data + begin, middle - begin, data + middle, end - middle,
+                  scratch + begin, comp);
+      else
+        MoveMerge(scratch + begin, middle - begin, scratch + middle,
+                  end - middle, data + begin, comp);
+    }
+    inData = !inData;
+  }
+
+  if (!inData)
+    std::move(scratch, scratch + count, data);
+}
+
+// One bottom-up round: merges neighbouring runs of `width` from `source`
+// into `target`. Each pair's output is cut into slices of about `slice`
+// elements so the last rounds, with few long runs, still spread out.
+template <typename Source, typename Target, typename Compare>
+void MergeRound(Source source, Target target, u64 count, u64 width, u64 slice,
+                Compare &comp, Category category) noexcept {
+  const u64 pairWidth = 2 * width;
+  const u64 pairs = (count + pairWidth - 1) / pairWidth;
+  const u64 slicesPerPair = (pairWidth + slice - 1) / slice;
+  const u64 sliceCount = pairs * slicesPerPair;
+
+  struct Pair {
+    u64 Base;
+    u64 CountA;
+    u64 CountB;
+  };
+  auto pairOf = [&](u64 index) {
+    const u64 base = (index / slicesPerPair) * pairWidth;
+    const u64 countA = std::min(width, count - base);
+    return Pair{base, countA, std::min(width, count - base - countA)};
+  };
+
+  // Find every slice's split before anything moves: merging a slice moves
+  // elements out of the source that a neighbour's split search would read.
+  ScratchBuffer<u64> splits(sliceCount, category);
+  if (!splits) {
+    for (u64 index = 0; index < sliceCount; index += slicesPerPair) {
+      const auto [base, countA, countB] = pairOf(index);
+      MoveMerge(source + base, countA, source + (base + countA), countB,
+                target + base, comp);
+    }
+    return;
+  }
+
+  ParallelFor(
+      0, sliceCount, 1,
+      [&](u64 index) {
+        const auto [base, countA, countB] = pairOf(index);
+        const u64 first = std::min((index % slicesPerPair) * slice,
+                                   countA + countB);
+        splits[index] = MergeSplit(source + base, countA,
+                                   source + (base + countA), countB, first,
+                                   comp);
+      },
+      JobPriority::Normal, category);
+
+  ParallelFor(
+      0, sliceCount, 1,
+      [&](u64 index) {
+        const auto [base, countA, countB] = pairOf(index);
+        const u64 sub = index % slicesPerPair;
+        const u64 first = std::min(sub * slice, countA + countB);
+        const u64 last = std::min(first + slice, countA + countB);
+        if (first >= last)
+          return;
+
+        // A pair's last slice ends where both runs do
+        const u64 aFirst = splits[index];
+        const u64 aLast =
+            sub + 1 < slicesPerPair ? splits[index + 1] : countA;
+        MoveMerge(source + (base + aFirst), aLast - aFirst,
+                  source + (base + countA + first - aFirst),
+                  (last - aLast) - (first - aFirst), target + (base + first),
+                  comp);
+      },
+      JobPriority::Normal, category);
+}
+
+template <typename T, typename Fn>
+using RadixKeyType = std::remove_cvref_t<std::invoke_result_t<Fn &, const T &>>;
+
+} // namespace detail
+
+// Reduces transform(x) over [first, last) with `reduce`, starting from
+// `init`. `reduce` must be associative; blocks are combined in order, so it
+// need not be commutative.
+template <std::random_access_iterator It, typename T, typename Reduce,
+          typename Transform>
+T ParallelTransformReduce(It first, It last, T init, Reduce reduce,
+                          Transform transform, Category category) noexcept {
+  GECKO_PROF_SCOPE(category, "ParallelTransformReduce");
+  const u64 count = static_cast<u64>(last - first);
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<T> partials(blocks > 1 ? blocks : 0, category);
+  if (!partials) {
+    for (; first != last; ++first)
+      init = reduce(std::move(init), transform(*first));
+    return init;
+  }
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        T value(transform(detail::At(first, begin)));
+        for (u64 i = begin + 1; i < end; ++i)
+          value = reduce(std::move(value), transform(detail::At(first, i)));
+        std::construct_at(&partials[block], std::move(value));
+      },
+      category);
+
+  for (u64 block = 0; block < blocks; ++block) {
+    init = reduce(std::move(init), std::move(partials[block]));
+    std::destroy_at(&partials[block]);
+  }
+  return init;
+}
+
+template <std::random_access_iterator It, typename T, typename Reduce>
+T ParallelReduce(It first, It last, T init, Reduce reduce,
+                 Category category) noexcept {
+  return ParallelTransformReduce(
+      first, last, std::move(init), std::move(reduce),
+      [](const auto &value) -> decltype(auto) { return value; }, category);
+}
+
+// out[i] = x[0] op ... op x[i]. `op` must be associative. `out` may be
+// `first` for an in-place scan. Returns the end of the output.
+template <std::random_access_iterator It, std::random_access_iterator Out,
+          typename Op>
+Out ParallelInclusiveScan(It first, It last, Out out, Op op,
+                          Category category) noexcept {
+  using T = std::iter_value_t<It>;
+  GECKO_PROF_SCOPE(category, "ParallelInclusiveScan");
+  const u64 count = static_cast<u64>(last - first);
+  if (count == 0)
+    return out;
+
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<T> carries(blocks > 1 ? blocks : 0, category);
+  if (!carries) {
+    T sum = detail::At(first, 0);
+    detail::At(out, 0) = sum;
+    for (u64 i = 1; i < count; ++i) {
+      sum = op(std::move(sum), detail::At(first, i));
+      detail::At(out, i) = sum;
+    }
+    return out + static_cast<std::iter_difference_t<Out>>(count);
+  }
+
+  // Sum every block, turn the sums into the carry into each block, then
+  // scan the blocks again with their carry.
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        T sum = detail::At(first, begin);
+        for (u64 i = begin + 1; i < end; ++i)
+          sum = op(std::move(sum), detail::At(first, i));
+        std::construct_at(&carries[block], std::move(sum));
+      },
+      category);
+
+  T running = std::move(carries[0]);
+  for (u64 block = 1; block < blocks; ++block) {
+    T blockSum = std::move(carries[block]);
+    carries[block] = running;
+    running = op(std::move(running), std::move(blockSum));
+  }
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        T sum = block == 0 ? T(detail::At(first, begin))
+                           : T(op(carries[block], detail::At(first, begin)));
+        detail::At(out, begin) = sum;
+        for (u64 i = begin + 1; i < end; ++i) {
+          sum = op(std::move(sum), detail::At(first, i));
+          detail::At(out, i) = sum;
+        }
+      },
+      category);
+
+  std::destroy_n(carries.Data(), blocks);
+  return out + static_cast<std::iter_difference_t<Out>>(count);
+}
+
+// out[i] = init op x[0] op ... op x[i - 1]. `op` must be associative. `out`
+// may be `first` for an in-place scan. Returns the end of the output.
+template <std::random_access_iterator It, std::random_access_iterator Out,
+          typename T, typename Op>
+Out ParallelExclusiveScan(It first, It last, Out out, T init, Op op,
+                          Category category) noexcept {
+  GECKO_PROF_SCOPE(category, "ParallelExclusiveScan");
+  const u64 count = static_cast<u64>(last - first);
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<T> carries(blocks > 1 ? blocks : 0, category);
+  if (!carries) {
+    for (u64 i = 0; i < count; ++i) {
+      // Read before writing, `out` may alias the input
+      T value = detail::At(first, i);
+      detail::At(out, i) = init;
+      init = op(std::move(init), std::move(value));
+    }
+    return out + static_cast<std::iter_difference_t<Out>>(count);
+  }
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        T sum = detail::At(first, begin);
+        for (u64 i = begin + 1; i < end; ++i)
+          sum = op(std::move(sum), detail::At(first, i));
+        std::construct_at(&carries[block], std::move(sum));
+      },
+      category);
+
+  T running = std::move(init);
+  for (u64 block = 0; block < blocks; ++block) {
+    T blockSum = std::move(carries[block]);
+    carries[block] = running;
+    running = op(std::move(running), std::move(blockSum));
+  }
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        T sum = carries[block];
+        for (u64 i = begin; i < end; ++i) {
+          T value = detail::At(first, i);
+          detail::At(out, i) = sum;
+          sum = op(std::move(sum), std::move(value));
+        }
+      },
+      category);
+
+  std::destroy_n(carries.Data(), blocks);
+  return out + static_cast<std::iter_difference_t<Out>>(count);
+}
+
+// Stable compaction: copies the elements matching `pred` to `out`, in order,
+// and returns the end of the output. `pred` runs once per element.
+template <std::random_access_iterator It, std::random_access_iterator Out,
+          typename Pred>
+Out ParallelCompact(It first, It last, Out out, Pred pred,
+                    Category category) noexcept {
+  GECKO_PROF_SCOPE(category, "ParallelCompact");
+  const u64 count = static_cast<u64>(last - first);
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<u8> keep(blocks > 1 ? count : 0, category);
+  detail::ScratchBuffer<u64> offsets(keep ? blocks : 0, category);
+  if (!offsets) {
+    for (; first != last; ++first) {
+      if (pred(*first))
+        *out++ = *first;
+    }
+    return out;
+  }
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        u64 kept = 0;
+        for (u64 i = begin; i < end; ++i) {
+          keep[i] = pred(detail::At(first, i)) ? 1 : 0;
+          kept += keep[i];
+        }
+        offsets[block] = kept;
+      },
+      category);
+
+  u64 total = 0;
+  for (u64 block = 0; block < blocks; ++block)
+    total += std::exchange(offsets[block], total);
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        u64 target = offsets[block];
+        for (u64 i = begin; i < end; ++i) {
+          if (keep[i])
+            detail::At(out, target++) = detail::At(first, i);
+        }
+      },
+      category);
+
+  return out + static_cast<std::iter_difference_t<Out>>(total);
+}
+
+// Stable partition: moves the elements matching `pred` to the front, keeping
+// the relative order on both sides, and returns the first non-matching one.
+// `pred` runs once per element.
+template <std::random_access_iterator It, typename Pred>
+It ParallelPartition(It first, It last, Pred pred,
+                     Category category) noexcept {
+  using T = std::iter_value_t<It>;
+  GECKO_PROF_SCOPE(category, "ParallelPartition");
+  const u64 count = static_cast<u64>(last - first);
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<u8> keep(blocks > 1 ? count : 0, category);
+  detail::ScratchBuffer<u64> offsets(keep ? blocks : 0, category);
+  detail::ScratchBuffer<T> moved(offsets ? count : 0, category);
+  if (!moved)
+    return std::stable_partition(first, last, pred);
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        u64 kept = 0;
+        for (u64 i = begin; i < end; ++i) {
+          keep[i] = pred(detail::At(first, i)) ? 1 : 0;
+          kept += keep[i];
+        }
+        offsets[block] = kept;
+      },
+      category);
+
+  u64 total = 0;
+  for (u64 block = 0; block < blocks; ++block)
+    total += std::exchange(offsets[block], total);
+
+  // Matching elements of a block go after those of earlier blocks, the
+  // rest after every matching element and the earlier blocks' rest.
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        u64 front = offsets[block];
+        u64 back = total + (begin - offsets[block]);
+        for (u64 i = begin; i < end; ++i) {
+          const u64 target = keep[i] ? front++ : back++;
+          std::construct_at(&moved[target], std::move(detail::At(first, i)));
+        }
+      },
+      category);
+
+  detail::ForEachBlock(
+      blocks,
+      [&](u64 block) {
+        const u64 begin = detail::BlockBegin(count, blocks, block);
+        const u64 end = detail::BlockBegin(count, blocks, block + 1);
+        for (u64 i = begin; i < end; ++i)
+          detail::At(first, i) = std::move(moved[i]);
+        std::destroy(moved.Data() + begin, moved.Data() + end);
+      },
+      category);
+
+  return first + static_cast<std::iter_difference_t<It>>(total);
+}
+
+// Stable merge sort. Blocks are sorted in parallel, then merged in rounds in
+// which every output slice is merged independently, so the final merges are
+// parallel too. Needs scratch for one copy of the range.
+template <std::random_access_iterator It, typename Compare>
+void ParallelMergeSort(It first, It last, Compare comp,
+                       Category category) noexcept {
+  using T = std::iter_value_t<It>;
+  GECKO_PROF_SCOPE(category, "ParallelMergeSort");
+  const u64 count = static_cast<u64>(last - first);
+  if (count < 2)
+    return;
+
+  detail::ScratchBuffer<T> scratch(count, category);
+  if (!scratch) {
+    std::stable_sort(first, last, comp);
+    return;
+  }
+
+  // Leaves of equal width (bar the last) so every merge round works on runs
+  // of one width.
+  const u64 blocks = detail::ParallelBlockCount(count);
+  const u64 leafWidth = (count + blocks - 1) / blocks;
+  const u64 leaves = (count + leafWidth - 1) / leafWidth;
+
+  // The scratch copy needs live objects: move the input in and sort there,
+  // with the input range as the other buffer.
+  T *data = scratch.Data();
+  detail::ForEachBlock(
+      leaves,
+      [&](u64 leaf) {
+        const u64 begin = leaf * leafWidth;
+        const u64 end = std::min(begin + leafWidth, count);
+        std::uninitialized_move(
+            first + static_cast<std::iter_difference_t<It>>(begin),
+            first + static_cast<std::iter_difference_t<It>>(end),
+            data + begin);
+        detail::SerialMergeSort(
+            data + begin,
+            first + static_cast<std::iter_difference_t<It>>(begin),
+            end - begin, comp);
+      },
+      category);
+
+  bool inScratch = true;
+  const u64 slice = std::max(ParallelMinBlockSize, leafWidth);
+  for (u64 width = leafWidth; width < count; width *= 2) {
+    if (inScratch)
+      detail::MergeRound(data, first, count, width, slice, comp, category);
+    else
+      detail::MergeRound(first, data, count, width, slice, comp, category);
+    inScratch = !inScratch;
+  }
+
+  detail::ForEachBlock(
+      leaves,
+      [&](u64 leaf) {
+        const u64 begin = leaf * leafWidth;
+        const u64 end = std::min(begin + leafWidth, count);
+        if (inScratch)
+          std::move(data + begin, data + end,
+                    first + static_cast<std::iter_difference_t<It>>(begin));
+        std::destroy(data + begin, data + end);
+      },
+      category);
+}
+
+template <std::random_access_iterator It>
+void ParallelMergeSort(It first, It last, Category category) noexcept {
+  ParallelMergeSort(first, last, std::less<>{}, category);
+}
+
+// Stable LSD radix sort by an unsigned integer key, one byte per pass.
+// Bytes that are the same in every key cost no pass, so small key ranges
+// sort faster. For contiguous ranges of trivially copyable elements;
+// needs scratch for one copy of the range.
+template <std::contiguous_iterator It, typename KeyFn>
+  requires std::is_trivially_copyable_v<std::iter_value_t<It>> &&
+           std::unsigned_integral<
+               detail::RadixKeyType<std::iter_value_t<It>, KeyFn>>
+void ParallelRadixSort(It first, It last, KeyFn key,
+                       Category category) noexcept {
+  using T = std::iter_value_t<It>;
+  using Key = detail::RadixKeyType<T, KeyFn>;
+  constexpr u32 Radix = 256;
+  GECKO_PROF_SCOPE(category, "ParallelRadixSort");
+
+  const u64 count = static_cast<u64>(last - first);
+  if (count < 2)
+    return;
+
+  const u64 blocks = detail::ParallelBlockCount(count);
+  detail::ScratchBuffer<T> scratch(count, category);
+  detail::ScratchBuffer<u64> counts(scratch ? blocks * Radix : 0, category);
+  if (!counts) {
+    std::stable_sort(first, last, [&key](const T &a, const T &b) {
+      return key(a) < key(b);
+    });
+    return;
+  }
+
+  T *source = std::to_address(first);
+  T *target = scratch.Data();
+  const Key firstKey = key(*source);
+  const Key varying = ParallelTransformReduce(
+      source, source + count, Key{0}, std::bit_or<>{},
+      [&key, firstKey](const T &value) -> Key {
+        return key(value) ^ firstKey;
+      },
+      category);
+
+  for (u32 shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+    if (((varying >> shift) & (Radix - 1)) == 0)
+      continue;
+
+    auto digit = [&key, shift](const T &value) {
+      return static_cast<u32>((key(value) >> shift) & (Radix - 1));
+    };
+
+    detail::ForEachBlock(
+        blocks,
+        [&](u64 block) {
+          u64 *histogram = &counts[block * Radix];
+          std::fill(histogram, histogram + Radix, 0);
+          const u64 begin = detail::BlockBegin(count, blocks, block);
+          const u64 end = detail::BlockBegin(count, blocks, block + 1);
+          for (u64 i = begin; i < end; ++i)
+            ++histogram[digit(source[i])];
+        },
+        category);
+
+    // Bucket-major, block-minor offsets keep equal keys in input order
+    u64 total = 0;
+    for (u32 bucket = 0; bucket < Radix; ++bucket) {
+      for (u64 block = 0; block < blocks; ++block)
+        total += std::exchange(counts[block * Radix + bucket], total);
+    }
+
+    detail::ForEachBlock(
+        blocks,
+        [&](u64 block) {
+          u64 *offsets = &counts[block * Radix];
+          const u64 begin = detail::BlockBegin(count, blocks, block);
+          const u64 end = detail::BlockBegin(count, blocks, block + 1);
+          for (u64 i = begin; i < end; ++i)
+            target[offsets[digit(source[i])]++] = source[i];
+        },
+        category);
+    std::swap(source, target);
+  }
+
+  if (source != std::to_address(first)) {
+    detail::ForEachBlock(
+        blocks,
+        [&](u64 block) {
+          const u64 begin = detail::BlockBegin(count, blocks, block);
+          const u64 end = detail::BlockBegin(count, blocks, block + 1);
+          std::memcpy(target + begin, source + begin,
+                      sizeof(T) * (end - begin));
+        },
+        category);
+  }
+}
+
+// Radix sort of unsigned integers by value.
+template <std::contiguous_iterator It>
+  requires std::unsigned_integral<std::iter_value_t<It>>
+void ParallelRadixSort(It first, It last, Category category) noexcept {
+  ParallelRadixSort(
+      first, last, [](std::iter_value_t<It> value) { return value; },
+      category);
+}
+
+} // namespace gecko
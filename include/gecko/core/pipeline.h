@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "api.h"
+#include "category.h"
+#include "inplace_function.h"
+#include "jobs.h"
+#include "types.h"
+
+namespace gecko {
+
+// How a Pipeline stage may run.
+enum class PipelineMode : u8 {
+  // One item at a time, in the order the first stage produced them.
+  SerialInOrder,
+  // One item at a time, in whatever order they arrive.
+  SerialOutOfOrder,
+  // Any number of items at once.
+  Parallel,
+};
+
+// An item moving through a Pipeline.
+struct PipelineItem {
+  // Position in the input order, from 0 for each run.
+  u64 Sequence{0};
+  // The token the item holds, in [0, tokens) for the run. Storage indexed by
+  // it is all the buffering a pipeline needs, and a token is only reused
+  // once its item has left the last stage.
+  u32 Token{0};
+};
+
+// Returns false to drop the item; from the first stage, false means there
+// is no more input. A stage that throws is logged and counts as false.
+using PipelineStageFunction =
+    InplaceFunction<bool(PipelineItem &), GECKO_JOB_FUNCTION_CAPACITY>;
+
+// Streams items through a chain of stages as jobs, e.g. read, decompress,
+// parse and publish. At most `tokens` items are in flight at once, so a slow
+// stage holds back the first one instead of letting buffers pile up, and
+// throughput approaches that of the slowest stage. An item is carried by one
+// job through as many stages as it can go; a serial stage that is busy
+// parks it until the stage frees up. Dropped items still take their turn in
+// later in-order stages, so order is kept.
+//
+//   std::vector<Chunk> chunks(8);
+//   Pipeline pipeline("Load");
+//   pipeline.AddStage(PipelineMode::SerialInOrder, [&](PipelineItem &item) {
+//     return file.Read(chunks[item.Token]);
+//   });
+//   pipeline.AddStage(PipelineMode::Parallel, [&](PipelineItem &item) {
+//     Decompress(chunks[item.Token]);
+//     return true;
+//   });
+//   pipeline.AddStage(PipelineMode::SerialInOrder, [&](PipelineItem &item) {
+//     Publish(chunks[item.Token]);
+//     return true;
+//   });
+//   pipeline.Run(8);
+//   pipeline.Wait();
+class Pipeline {
+public:
+  GECKO_API explicit Pipeline(const char *name = "Pipeline",
+                              Category category = Category{0}) noexcept;
+  GECKO_API ~Pipeline();
+
+  Pipeline(const Pipeline &) = delete;
+  Pipeline &operator=(const Pipeline &) = delete;
+
+  // Stages run in the order they were added. The first one produces items
+  // and runs one at a time whatever its mode says.
+  GECKO_API bool AddStage(PipelineMode mode, PipelineStageFunction function,
+                          JobPriority priority = JobPriority::Normal) noexcept;
+
+  // Starts a run with at most `tokens` items in flight. Runs serially on
+  // this thread when there are no workers. Returns false if there are no
+  // stages or it cannot allocate its per-token state; the first run with a
+  // given shape allocates, later ones do not.
+  GECKO_API bool Run(u32 tokens) noexcept;
+
+  // Blocks until the current run has finished, running queued jobs on this
+  // thread in the meantime.
+  GECKO_API void Wait() noexcept;
+
+  GECKO_API bool IsComplete() const noexcept;
+  u32 StageCount() const noexcept { return static_cast<u32>(m_Stages.size()); }
+
+private:
+  static constexpr u32 NoToken = ~0u;
+
+  struct Stage {
+    PipelineMode Mode{PipelineMode::Parallel};
+    PipelineStageFunction Function;
+    JobPriority Priority{JobPriority::Normal};
+  };
+
+  // Per-run state of a serial stage. Stage 0's lock also guards the free
+  // tokens and the end of input.
+  struct SerialState {
+    std::mutex Lock;
+    bool Busy{false};
+    u64 NextSequence{0};
+  };
+
+  void RunSerially() noexcept;
+  // Continues `token` at `stage` in a job; the item already holds the stage.
+  void Launch(u32 token, u32 stage) noexcept;
+  void Resume(u32 token, u32 stage, bool holdsStage) noexcept;
+  // Runs a stage's function; an exception counts as dropping the item.
+  bool RunStage(u32 stage, PipelineItem &item) noexcept;
+  bool Enter(u32 stage, u32 token) noexcept;
+  void Leave(u32 stage) noexcept;
+  void Finish(u32 token) noexcept;
+  void FinishRun() noexcept;
+  u32 TakeInputToken() noexcept;
+
+  const char *m_Name{nullptr};
+  Category m_Category{};
+  std::vector<Stage> m_Stages;
+
+  // Sized by Run for the stage and token counts.
+  std::unique_ptr<SerialState[]> m_Serial;
+  u32 m_SerialCount{0};
+  std::vector<PipelineItem> m_Items;
+  std::vector<u8> m_Dropped;
+  std::vector<u8> m_Waiting; // stage * tokens + token
+  std::vector<u32> m_FreeTokens;
+  u32 m_Tokens{0};
+  u64 m_NextSequence{0};
+  bool m_InputDone{false};
+
+  std::atomic<bool> m_Running{false};
+  // Held job of the current run, released by FinishRun.
+  JobHandle m_Sink{};
+};
+
+} // namespace gecko
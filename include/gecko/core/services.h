@@ -52,12 +52,29 @@ struct NullJobSystem final : IJobSystem {
   Submit(JobFunction job, const JobHandle *dependencies, u32 dependencyCount,
          JobPriority priority = JobPriority::Normal,
          Category category = Category{0}) noexcept override;
+  GECKO_API virtual void SubmitBatch(JobDesc *jobs, u32 count,
+                                     JobHandle *outHandles) noexcept override;
+  GECKO_API virtual JobHandle SubmitAt(JobDesc desc,
+                                       u64 deadlineNs) noexcept override;
+  GECKO_API virtual PeriodicJob SubmitPeriodic(JobDesc desc,
+                                               u64 periodNs) noexcept override;
+  GECKO_API virtual void CancelPeriodic(PeriodicJob job) noexcept override;
+  GECKO_API virtual JobHandle SubmitHeld(JobDesc desc) noexcept override;
+  GECKO_API virtual bool AddHold(JobHandle handle) noexcept override;
+  GECKO_API virtual void ReleaseHold(JobHandle handle) noexcept override;
+  GECKO_API virtual JobHandle
+  SubmitWithResult(JobDesc desc, const JobResultDesc &result,
+                   void *&outStorage) noexcept override;
+  GECKO_API virtual void
+  ReleaseResult(JobHandle handle, void *storage,
+                const JobResultDesc &result) noexcept override;
   GECKO_API virtual void Wait(JobHandle handle) noexcept override;
   GECKO_API virtual void WaitAll(const JobHandle *handles,
                                  u32 count) noexcept override;
   GECKO_API virtual bool IsComplete(JobHandle handle) noexcept override;
   GECKO_API virtual u32 WorkerThreadCount() const noexcept override;
   GECKO_API virtual void ProcessJobs(u32 maxJobs = 1) noexcept override;
+  GECKO_API virtual JobThread RegisterThread() noexcept override;
 
   GECKO_API virtual bool Init() noexcept override;
   GECKO_API virtual void Shutdown() noexcept override;
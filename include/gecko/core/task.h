@@ -0,0 +1,363 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <semaphore>
+#include <type_traits>
+#include <utility>
+
+#include "api.h"
+#include "assert.h"
+#include "jobs.h"
+#include "optional.h"
+#include "thread.h"
+
+namespace gecko {
+
+// Lazily started coroutine. A Task does nothing until it is awaited, started
+// with Start(), or handed to WaitForTask; a started task can still be awaited
+// once to collect its result. Awaiting a job handle, a group of handles or
+// ResumeOnWorker() inside a task suspends it without holding a thread: the
+// rest of the coroutine is queued as a job that runs once the awaited work is
+// done.
+//
+//   Task<Mesh> LoadMesh(const char *path) {
+//     co_await ResumeOnWorker();
+//     Bytes bytes = ReadFile(path);
+//     co_await SubmitJob([&] { Decode(bytes); });
+//     co_return Upload(bytes);
+//   }
+template <typename T = void> class Task;
+
+template <typename T> T WaitForTask(Task<T> task) noexcept;
+
+namespace detail {
+
+struct TaskPromiseBase {
+  struct FinalAwaiter {
+    bool await_ready() const noexcept { return false; }
+
+    template <typename Promise>
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+      TaskPromiseBase &promise = handle.promise();
+      // Claim the continuation and the waiter before publishing Done: as
+      // soon as Done is visible the owner may destroy the frame.
+      void *continuation =
+          promise.Continuation.exchange(FinishedMarker(),
+                                        std::memory_order_acq_rel);
+      const JobHandle sink = promise.Sink;
+      std::binary_semaphore *signal = promise.Signal;
+      promise.Done.store(true, std::memory_order_release);
+      if (sink.IsValid()) {
+        if (IJobSystem *jobSystem = GetJobSystem())
+          jobSystem->ReleaseHold(sink);
+      }
+      if (signal)
+        signal->release();
+      if (continuation)
+        return std::coroutine_handle<>::from_address(continuation);
+      return std::noop_coroutine();
+    }
+
+    void await_resume() const noexcept {}
+  };
+
+  // Stored in Continuation once the task has finished, so an awaiter that
+  // arrives late knows to carry on instead of waiting to be resumed.
+  static void *FinishedMarker() noexcept {
+    static char marker;
+    return &marker;
+  }
+
+  std::suspend_always initial_suspend() const noexcept { return {}; }
+  FinalAwaiter final_suspend() const noexcept { return {}; }
+
+  void unhandled_exception() const noexcept {
+    GECKO_ASSERT(false && "Exception escaped a gecko::Task");
+    std::terminate();
+  }
+
+  std::atomic<void *> Continuation{nullptr};
+  std::atomic<bool> Done{false};
+  bool Started{false};
+  // Set by WaitForTask before the task starts; released when it finishes.
+  JobHandle Sink{};
+  std::binary_semaphore *Signal{nullptr};
+};
+
+template <typename T> struct TaskPromise : TaskPromiseBase {
+  Task<T> get_return_object() noexcept;
+
+  template <typename U>
+    requires std::is_constructible_v<T, U &&>
+  void return_value(U &&value) noexcept(
+      std::is_nothrow_constructible_v<T, U &&>) {
+    Value.emplace(std::forward<U>(value));
+  }
+
+  T TakeResult() noexcept {
+    GECKO_ASSERT(Value && "Task finished without a result");
+    return std::move(*Value);
+  }
+
+  Optional<T> Value;
+};
+
+template <> struct TaskPromise<void> : TaskPromiseBase {
+  Task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+  void TakeResult() const noexcept {}
+};
+
+} // namespace detail
+
+template <typename T> class Task {
+public:
+  using promise_type = detail::TaskPromise<T>;
+
+  Task() noexcept = default;
+  explicit Task(std::coroutine_handle<promise_type> handle) noexcept
+      : m_Handle(handle) {}
+
+  Task(Task &&other) noexcept
+      : m_Handle(std::exchange(other.m_Handle, nullptr)) {}
+
+  Task &operator=(Task &&other) noexcept {
+    if (this != &other) {
+      Destroy();
+      m_Handle = std::exchange(other.m_Handle, nullptr);
+    }
+    return *this;
+  }
+
+  Task(const Task &) = delete;
+  Task &operator=(const Task &) = delete;
+
+  // A task must be finished (or never started) when it is destroyed; a
+  // suspended one still has a job queued to resume it.
+  ~Task() { Destroy(); }
+
+  bool IsValid() const noexcept { return static_cast<bool>(m_Handle); }
+
+  bool IsDone() const noexcept {
+    return !m_Handle || m_Handle.promise().Done.load(std::memory_order_acquire);
+  }
+
+  // Runs the task on this thread until its first suspension point. Poll
+  // IsDone() and collect the value with Result() afterwards.
+  void Start() noexcept {
+    GECKO_ASSERT(m_Handle && !m_Handle.promise().Started &&
+                 "Task already started");
+    m_Handle.promise().Started = true;
+    m_Handle.resume();
+  }
+
+  // Moves the result out of a finished task.
+  T Result() noexcept {
+    GECKO_ASSERT(IsDone() && "Task is not finished yet");
+    return m_Handle.promise().TakeResult();
+  }
+
+  auto operator co_await() && noexcept { return Awaiter{m_Handle}; }
+  auto operator co_await() & noexcept { return Awaiter{m_Handle}; }
+
+private:
+  template <typename U> friend U WaitForTask(Task<U> task) noexcept;
+
+  struct Awaiter {
+    std::coroutine_handle<promise_type> Handle;
+
+    bool await_ready() const noexcept {
+      return !Handle || Handle.promise().Done.load(std::memory_order_acquire);
+    }
+
+    std::coroutine_handle<>
+    await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      promise_type &promise = Handle.promise();
+      if (!promise.Started) {
+        // Start the child right here and come back when it finishes.
+        promise.Started = true;
+        promise.Continuation.store(awaiting.address(),
+                                   std::memory_order_relaxed);
+        return Handle;
+      }
+
+      // Already running elsewhere: leave our continuation for it, unless it
+      // finished in the meantime.
+      void *expected = nullptr;
+      if (promise.Continuation.compare_exchange_strong(
+              expected, awaiting.address(), std::memory_order_acq_rel,
+              std::memory_order_acquire))
+        return std::noop_coroutine();
+      GECKO_ASSERT(expected == promise_type::FinishedMarker() &&
+                   "Task awaited twice");
+      return awaiting;
+    }
+
+    T await_resume() noexcept { return Handle.promise().TakeResult(); }
+  };
+
+  void Destroy() noexcept {
+    if (!m_Handle)
+      return;
+    GECKO_ASSERT((!m_Handle.promise().Started || IsDone()) &&
+                 "Destroying a suspended Task");
+    m_Handle.destroy();
+    m_Handle = nullptr;
+  }
+
+  std::coroutine_handle<promise_type> m_Handle;
+};
+
+namespace detail {
+
+template <typename T> Task<T> TaskPromise<T>::get_return_object() noexcept {
+  return Task<T>{std::coroutine_handle<TaskPromise<T>>::from_promise(*this)};
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept {
+  return Task<void>{
+      std::coroutine_handle<TaskPromise<void>>::from_promise(*this)};
+}
+
+} // namespace detail
+
+// Suspends until every handle has completed, then resumes on a worker as a
+// job. Completes immediately when nothing is pending, and also falls back to
+// resuming inline if the job system cannot take the continuation.
+class JobAwaiter {
+public:
+  JobAwaiter(JobHandle handle, JobPriority priority = JobPriority::Normal,
+             Category category = Category{0}) noexcept
+      : m_Handle(handle), m_Priority(priority), m_Category(category) {}
+
+  JobAwaiter(const JobHandle *handles, u32 count,
+             JobPriority priority = JobPriority::Normal,
+             Category category = Category{0}) noexcept
+      : m_Handles(handles), m_Count(count), m_Priority(priority),
+        m_Category(category) {}
+
+  bool await_ready() const noexcept {
+    const JobHandle *handles = m_Handles ? m_Handles : &m_Handle;
+    for (u32 i = 0; i < m_Count; ++i) {
+      if (!IsJobComplete(handles[i]))
+        return false;
+    }
+    return true;
+  }
+
+  bool await_suspend(std::coroutine_handle<> continuation) noexcept {
+    // Once Submit succeeds the coroutine may resume (and this awaiter die)
+    // on another thread, so nothing below may touch members.
+    const JobHandle resume = SubmitJob(
+        [continuation]() { continuation.resume(); },
+        m_Handles ? m_Handles : &m_Handle, m_Count, m_Priority, m_Category);
+    return resume.IsValid();
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  JobHandle m_Handle;
+  const JobHandle *m_Handles{nullptr};
+  u32 m_Count{1};
+  JobPriority m_Priority{JobPriority::Normal};
+  Category m_Category{};
+};
+
+inline JobAwaiter operator co_await(JobHandle handle) noexcept {
+  return JobAwaiter{handle};
+}
+
+// co_await WhenAll(handles, count): resume once all of them are done. The
+// array only needs to live until the co_await expression suspends.
+inline JobAwaiter WhenAll(const JobHandle *handles, u32 count,
+                          JobPriority priority = JobPriority::Normal,
+                          Category category = Category{0}) noexcept {
+  return JobAwaiter{handles, count, priority, category};
+}
+
+// co_await ResumeOnWorker(): continue the coroutine as a job on the pool.
+// Without worker threads the coroutine simply keeps running.
+class ResumeOnWorker {
+public:
+  explicit ResumeOnWorker(JobPriority priority = JobPriority::Normal,
+                          Category category = Category{0}) noexcept
+      : m_Priority(priority), m_Category(category) {}
+
+  bool await_ready() const noexcept {
+    IJobSystem *jobSystem = GetJobSystem();
+    return !jobSystem || jobSystem->WorkerThreadCount() == 0;
+  }
+
+  bool await_suspend(std::coroutine_handle<> continuation) noexcept {
+    const JobHandle resume = SubmitJob(
+        [continuation]() { continuation.resume(); }, m_Priority, m_Category);
+    return resume.IsValid();
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  JobPriority m_Priority{JobPriority::Normal};
+  Category m_Category{};
+};
+
+// co_await ResumeOnThread(thread): continue the coroutine on a registered
+// thread (see RegisterJobThread) the next time it processes jobs. Keeps
+// running where it is if the thread is invalid.
+class ResumeOnThread {
+public:
+  explicit ResumeOnThread(JobThread thread,
+                          JobPriority priority = JobPriority::Normal,
+                          Category category = Category{0}) noexcept
+      : m_Thread(thread), m_Priority(priority), m_Category(category) {}
+
+  bool await_ready() const noexcept {
+    return !m_Thread.IsValid() || !GetJobSystem();
+  }
+
+  bool await_suspend(std::coroutine_handle<> continuation) noexcept {
+    const JobHandle resume =
+        SubmitJob(m_Thread, [continuation]() { continuation.resume(); },
+                  nullptr, 0, m_Priority, m_Category);
+    return resume.IsValid();
+  }
+
+  void await_resume() const noexcept {}
+
+private:
+  JobThread m_Thread{};
+  JobPriority m_Priority{JobPriority::Normal};
+  Category m_Category{};
+};
+
+// Starts a task on this thread and blocks until it finishes, running queued
+// jobs in the meantime. Meant for non-coroutine code at the edge of an async
+// pipeline.
+template <typename T> T WaitForTask(Task<T> task) noexcept {
+  GECKO_ASSERT(task.IsValid() && "WaitForTask needs a task");
+  // The final awaiter releases a held job, so IJobSystem::Wait can keep
+  // running queued jobs here, including ones the task sends back to this
+  // thread, before it blocks. Without a job system to hold one, it
+  // signals a semaphore instead.
+  std::binary_semaphore signal{0};
+  IJobSystem *jobSystem = GetJobSystem();
+  auto &promise = task.m_Handle.promise();
+  promise.Sink = jobSystem ? jobSystem->SubmitHeld(JobDesc{}) : JobHandle{};
+  if (!promise.Sink.IsValid())
+    promise.Signal = &signal;
+
+  const JobHandle sink = promise.Sink;
+  task.Start();
+  if (sink.IsValid())
+    jobSystem->Wait(sink);
+  else
+    signal.acquire();
+  return task.Result();
+}
+
+} // namespace gecko
@@ -32,6 +32,17 @@ GECKO_API inline void SleepNs(u64 nanoseconds) noexcept {
 // Yield current thread's time slice
 GECKO_API inline void YieldThread() noexcept { std::this_thread::yield(); }
 
+// Hint to the CPU that we are busy-waiting (x86 `pause`); no-op elsewhere
+GECKO_API void CpuRelax() noexcept;
+
+// Name the calling thread for debuggers and profilers. Names longer than the
+// platform limit (15 characters on Linux) are truncated.
+GECKO_API void SetCurrentThreadName(const char *name) noexcept;
+
+// Restrict the calling thread to the given logical CPUs. Returns false if
+// the platform does not support it or the request was rejected.
+GECKO_API bool PinCurrentThread(const u32 *cpus, u32 count) noexcept;
+
 // Spin-wait for a short duration (busy wait)
 GECKO_API void SpinWaitNs(u64 nanoseconds) noexcept;
 
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// One logical CPU (hardware thread) the process is allowed to run on.
+struct CpuInfo {
+  u32 Id{0};          // OS logical CPU number
+  u32 Core{0};        // Dense physical core index, shared by SMT siblings
+  u32 SmtIndex{0};    // 0 for the first hardware thread of a core
+  u32 CacheDomain{0}; // Dense index of the last-level cache this CPU sits on
+  u32 NumaNode{0};
+  u32 Package{0};
+};
+
+// Snapshot of the machine layout, restricted to the process affinity mask.
+// CPUs are sorted so that neighbours share as much as possible: by NUMA
+// node, cache domain, core, then SMT index.
+struct CpuTopology {
+  std::vector<CpuInfo> Cpus;
+  u32 CoreCount{0};
+  u32 CacheDomainCount{0};
+  u32 NumaNodeCount{0};
+  u32 PackageCount{0};
+};
+
+// Reads /sys/devices/system/cpu on Linux. Elsewhere, or when sysfs is not
+// readable, every logical CPU is reported as its own core in a single cache
+// domain.
+CpuTopology DetectCpuTopology() noexcept;
+
+// CPUs the process may keep busy under the cgroup v2 cpu.max limits along
+// its cgroup path (quota / period of the tightest one, rounded up). 0 when
+// nothing limits it or the limits cannot be read, e.g. outside Linux. The
+// quota can change at any time, so this reads it afresh on every call.
+u32 DetectCpuQuota() noexcept;
+
+} // namespace gecko::runtime
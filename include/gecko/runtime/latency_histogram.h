@@ -0,0 +1,98 @@
+#pragma once
+
+#include <bit>
+
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// Log-linear (HDR style) histogram of nanosecond durations. Values below
+// SubBucketCount are exact; every power of two above that is split into
+// SubBucketCount linear buckets, so a reported percentile is within 12.5% of
+// the true value. Durations past 2^MaxExponent ns (~68 s) land in the last
+// bucket.
+struct LatencyHistogram {
+  static constexpr u32 SubBucketBits = 3;
+  static constexpr u32 SubBucketCount = 1u << SubBucketBits;
+  static constexpr u32 MaxExponent = 36;
+  static constexpr u32 BucketCount =
+      SubBucketCount + (MaxExponent - SubBucketBits + 1) * SubBucketCount;
+
+  static constexpr u32 BucketIndex(u64 ns) noexcept {
+    if (ns < SubBucketCount)
+      return static_cast<u32>(ns);
+    u32 exponent = static_cast<u32>(std::bit_width(ns)) - 1;
+    if (exponent > MaxExponent)
+      return BucketCount - 1;
+    const u32 sub = static_cast<u32>(ns >> (exponent - SubBucketBits)) &
+                    (SubBucketCount - 1);
+    return SubBucketCount + (exponent - SubBucketBits) * SubBucketCount + sub;
+  }
+
+  // Largest value that maps to `index`.
+  static constexpr u64 BucketUpperBound(u32 index) noexcept {
+    if (index < SubBucketCount)
+      return index;
+    const u32 exponent = (index - SubBucketCount) / SubBucketCount +
+                         SubBucketBits;
+    const u64 sub = (index - SubBucketCount) % SubBucketCount;
+    const u64 width = u64{1} << (exponent - SubBucketBits);
+    return (u64{1} << exponent) + (sub + 1) * width - 1;
+  }
+
+  void Record(u64 ns) noexcept {
+    ++Buckets[BucketIndex(ns)];
+    ++Count;
+    SumNs += ns;
+    if (ns > MaxNs)
+      MaxNs = ns;
+  }
+
+  void Merge(const LatencyHistogram &other) noexcept {
+    for (u32 i = 0; i < BucketCount; ++i)
+      Buckets[i] += other.Buckets[i];
+    Count += other.Count;
+    SumNs += other.SumNs;
+    if (other.MaxNs > MaxNs)
+      MaxNs = other.MaxNs;
+  }
+
+  // Removes an earlier snapshot of the same histogram, leaving what was
+  // recorded since. MaxNs stays the all-time maximum.
+  void Subtract(const LatencyHistogram &earlier) noexcept {
+    for (u32 i = 0; i < BucketCount; ++i)
+      Buckets[i] -= earlier.Buckets[i];
+    Count -= earlier.Count;
+    SumNs -= earlier.SumNs;
+  }
+
+  // Upper bound of the bucket holding the given percentile (0-100), clamped
+  // to the largest recorded value. Returns 0 when empty.
+  u64 Percentile(double percentile) const noexcept {
+    if (Count == 0)
+      return 0;
+    u64 rank =
+        static_cast<u64>(percentile / 100.0 * static_cast<double>(Count));
+    if (rank >= Count)
+      rank = Count - 1;
+
+    u64 seen = 0;
+    for (u32 i = 0; i < BucketCount; ++i) {
+      seen += Buckets[i];
+      if (seen > rank) {
+        const u64 bound = BucketUpperBound(i);
+        return bound < MaxNs ? bound : MaxNs;
+      }
+    }
+    return MaxNs;
+  }
+
+  u64 MeanNs() const noexcept { return Count ? SumNs / Count : 0; }
+
+  u64 Buckets[BucketCount]{};
+  u64 Count{0};
+  u64 SumNs{0};
+  u64 MaxNs{0};
+};
+
+} // namespace gecko::runtime
@@ -56,14 +56,24 @@ private:
   std::atomic<bool> m_Run{true};
   std::atomic<u64> m_Dropped{0};
 
-  JobHandle m_ConsumerJob;
+  // Delayed job that drains the ring into the sinks. m_DrainPending is set
+  // while one is queued or running, so emits schedule at most one at a time.
+  std::atomic<JobHandle> m_Consumer{};
+  std::atomic<bool> m_DrainPending{false};
+  // Consumer jobs whose function the job system still holds.
+  std::atomic<u32> m_ActiveConsumers{0};
+  std::atomic<u64> m_ConsumerRuns{0};
+  // Held by whichever thread is reading the ring; it has a single consumer.
+  std::atomic_flag m_InlineDrain;
   Category m_LoggerCategory;
 
   IProfiler *m_Profiler;
 
   void ProcessLogEntries() noexcept;
-  void TryScheduleConsumerJob() noexcept;
-  void ScheduleNextConsumerJob() noexcept;
+  void ScheduleConsumer() noexcept;
+  void RunConsumer() noexcept;
+  void DrainPending() noexcept;
+  void WaitForConsumers() noexcept;
   bool HasPendingEntries() const noexcept;
   static u64 NowNs() noexcept;
   static u32 ThreadId() noexcept;
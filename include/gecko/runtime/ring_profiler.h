@@ -41,12 +41,24 @@ private:
 
   // Async consumer system
   std::atomic<bool> m_Run{true};
-  JobHandle m_ConsumerJob{};
+  // Delayed job that drains the ring into the sinks. m_DrainPending is set
+  // while one is queued or running, so emits schedule at most one at a time.
+  // Cleared m_UseConsumer makes Emit drain in place instead.
+  std::atomic<bool> m_UseConsumer{true};
+  std::atomic<JobHandle> m_Consumer{};
+  std::atomic<bool> m_DrainPending{false};
+  // Consumer jobs whose function the job system still holds.
+  std::atomic<u32> m_ActiveConsumers{0};
+  std::atomic<u64> m_ConsumerRuns{0};
+  // Held by whichever thread is reading the ring; it has a single consumer.
+  std::atomic_flag m_InlineDrain{};
   Category m_ProfilerCategory{};
 
   void ProcessProfEvents() noexcept;
-  void TryScheduleConsumerJob() noexcept;
-  void ScheduleNextConsumerJob() noexcept;
+  void ScheduleConsumer() noexcept;
+  void RunConsumer() noexcept;
+  void DrainPending() noexcept;
+  void WaitForConsumers() noexcept;
   bool HasPendingEvents() const noexcept;
 
   static u64 MonotonicNowNs() noexcept;
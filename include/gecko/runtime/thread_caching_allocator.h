@@ -0,0 +1,143 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+#include "gecko/core/category.h"
+#include "gecko/core/memory.h"
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// Small-object allocator in front of an upstream allocator. Requests up to
+// MaxSmallSize are rounded to one of ClassCount size classes and served from
+// a per-thread free list, so the common Alloc/Free touches no shared state.
+// A thread refills or drains its list a batch at a time against a central,
+// per-class pool; the central pools carve SpanSize spans out of chunks taken
+// from upstream. Larger or over-aligned requests pass straight through to
+// upstream, as do small ones when no span can be carved or mapped.
+//
+// Per-thread caches need a registry entry and a thread-local slot. At most
+// MaxInstances (16) allocators are registered at once, and each thread has
+// CacheSlotCount (4) slots; beyond either limit the allocator still works,
+// but the threads concerned go to the central pools on every Alloc and Free.
+//
+// Free looks the block up by address, so the size may be 0 (unsized
+// operator delete) and blocks may be freed on any thread. Memory is only
+// returned to upstream when the allocator is destroyed, which must happen
+// after every block it handed out is freed. Init is optional, so it works
+// under TrackingAllocator: Tracking -> ThreadCaching -> System.
+class ThreadCachingAllocator final : public IAllocator {
+public:
+  static constexpr u32 ClassCount = 32;
+  static constexpr u64 MaxSmallSize = 8192;
+  static constexpr u64 SpanSize = 64 * 1024;
+  static constexpr u64 ChunkSize = 16 * SpanSize;
+  static constexpr u32 MaxInstances = 16;
+  static constexpr u32 CacheSlotCount = 4;
+
+  explicit ThreadCachingAllocator(IAllocator *upstream) noexcept;
+  ~ThreadCachingAllocator() override;
+
+  ThreadCachingAllocator(const ThreadCachingAllocator &) = delete;
+  ThreadCachingAllocator &operator=(const ThreadCachingAllocator &) = delete;
+
+  virtual void *Alloc(u64 size, u32 alignment,
+                      Category category) noexcept override;
+  virtual void Free(void *ptr, u64 size, u32 alignment,
+                    Category category) noexcept override;
+
+  // Returns the calling thread's cached blocks to the central pools. Threads
+  // do this on their own when they exit.
+  void FlushThreadCache() noexcept;
+
+  // Bytes currently held in spans, whether handed out or cached.
+  u64 ReservedBytes() const noexcept;
+
+  virtual bool Init() noexcept override;
+  virtual void Shutdown() noexcept override;
+
+  static constexpr u64 ClassSize(u32 sizeClass) noexcept {
+    if (sizeClass < 8)
+      return 16 * u64(sizeClass + 1);
+    u32 log = 8 + (sizeClass - 8) / 4;
+    u32 index = (sizeClass - 8) % 4;
+    return (u64{1} << (log - 1)) + (index + 1) * (u64{1} << (log - 3));
+  }
+
+private:
+  struct FreeBlock {
+    FreeBlock *Next;
+  };
+
+  struct FreeList {
+    FreeBlock *Head{nullptr};
+    u32 Count{0};
+  };
+
+  struct ThreadCache {
+    FreeList Lists[ClassCount];
+    // Every cache this allocator owns, live or parked.
+    ThreadCache *NextOwned{nullptr};
+    ThreadCache *NextParked{nullptr};
+  };
+
+  struct alignas(64) CentralList {
+    std::mutex Mutex;
+    FreeBlock *Head{nullptr};
+    u32 Count{0};
+  };
+
+  struct ChunkNode {
+    void *Base;
+    ChunkNode *Next;
+  };
+
+  friend struct ThreadCacheReleaser;
+
+  static constexpr u32 NoClass = ~0u;
+
+  static u32 SizeClassFor(u64 size, u32 alignment) noexcept;
+  static u32 BatchSize(u32 sizeClass) noexcept;
+
+  u32 SizeClassOf(const void *ptr) const noexcept;
+
+  ThreadCache *LocalCache() noexcept;
+  ThreadCache *AcquireCache() noexcept;
+  void ReleaseCache(ThreadCache *cache) noexcept;
+
+  // Detaches up to `count` blocks from the central list, carving a new span
+  // when it runs dry. Returns the number of blocks chained from `head`.
+  u32 TakeFromCentral(u32 sizeClass, u32 count, FreeBlock *&head) noexcept;
+  void ReturnToCentral(u32 sizeClass, FreeBlock *head, FreeBlock *tail,
+                       u32 count) noexcept;
+  void Drain(u32 sizeClass, FreeList &list, u32 count) noexcept;
+
+  // Carves a span for `sizeClass` and threads it into a list. Called with the
+  // class's central mutex held.
+  u32 CarveSpan(u32 sizeClass, FreeBlock *&head, FreeBlock *&tail) noexcept;
+  void *NextSpanLocked() noexcept;
+  bool MapSpanLocked(void *span, u32 sizeClass) noexcept;
+
+  IAllocator *m_Upstream{nullptr};
+  // Key for the per-thread cache slots; 0 when no slot could be registered,
+  // in which case every thread goes to the central pools.
+  u64 m_Id{0};
+
+  CentralList m_Central[ClassCount];
+
+  // Two-level map from address >> 16 to size class + 1, 0 for memory that is
+  // not ours. Built lazily under m_SpanMutex.
+  std::atomic<u8 **> m_PageMap{nullptr};
+  std::mutex m_SpanMutex;
+  ChunkNode *m_Chunks{nullptr};
+  u8 *m_ChunkCursor{nullptr};
+  u8 *m_ChunkEnd{nullptr};
+  std::atomic<u64> m_ReservedBytes{0};
+
+  std::mutex m_CacheMutex;
+  ThreadCache *m_OwnedCaches{nullptr};
+  ThreadCache *m_ParkedCaches{nullptr};
+};
+
+} // namespace gecko::runtime
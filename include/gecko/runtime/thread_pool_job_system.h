@@ -2,57 +2,217 @@
 
 #include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
 #include "gecko/core/jobs.h"
+#include "gecko/core/time.h"
+#include "gecko/runtime/latency_histogram.h"
+#include "gecko/runtime/timer_wheel.h"
 
 namespace gecko::runtime {
 
+struct Job;
+template <typename T> class BoundedMpmcQueue;
+struct WorkerTelemetry;
+
+// One "successor waits on dependency" link. Edges are owned by the successor
+// and threaded into the dependency's successor list, so recording a
+// dependency never allocates as long as the successor's inline edges suffice.
+struct JobDependencyEdge {
+  Job *Successor{nullptr};
+  JobDependencyEdge *Next{nullptr};
+};
+
+// Pooled job slot. Slots are allocated once in Init and recycled through a
+// lock-free free list, so steady-state Submit does not touch the heap.
 struct Job {
+  static constexpr u32 InlineDependencyCount = 4;
+
   JobFunction Function;
-  JobPriority Priority;
-  Category Cat;
+  JobPriority Priority{JobPriority::Normal};
+  Category Cat{};
   JobHandle Handle;
-  std::vector<JobHandle> Dependencies;
-  std::atomic<bool> Completed{false};
+  u64 SubmitNs{0};
+  // Index of the worker group that runs it, resolved at submit.
+  u8 Group{0};
+  // Registered thread that runs it instead (index + 1), 0 for the pool.
+  u8 Thread{0};
+  JobFlags Flags{JobFlags::None};
+  const CancellationToken *Cancellation{nullptr};
+  // Set by a dependency that was cancelled before this job became ready.
+  std::atomic<bool> DependencyCancelled{false};
+
+  // Bumped when the job completes. A handle names a slot plus the generation
+  // it was issued for, so any mismatch means that job has finished.
+  std::atomic<u32> Generation{0};
+  // Threads blocked on Generation; completion only notifies when non-zero.
+  std::atomic<u32> Waiters{0};
+
+  // Unfinished dependencies plus one reference held by Submit while it wires
+  // up the edges. The job is queued by whoever drops this to zero, so blocked
+  // jobs never sit in a run queue.
+  std::atomic<u32> PendingDependencies{1};
+
+  // Jobs waiting on this one. The generation is bumped under this lock at
+  // completion; a dependent holding an older generation treats the
+  // dependency as already satisfied.
+  std::atomic_flag SuccessorLock;
+  JobDependencyEdge *Successors{nullptr};
+
+  // Edges for this job's own dependencies. More than InlineDependencyCount
+  // spills into OverflowEdges, the only allocation Submit can make.
+  JobDependencyEdge InlineEdges[InlineDependencyCount];
+  JobDependencyEdge *OverflowEdges{nullptr};
+  u32 OverflowEdgeCount{0};
 
-  Job() = default;
-  Job(JobFunction func, JobPriority prio, gecko::Category cat,
-      JobHandle handle) noexcept
-      : Function(std::move(func)), Priority(prio), Cat(cat), Handle(handle) {}
+  // Free list link: index + 1 of the next free slot, 0 terminates.
+  std::atomic<u32> NextFree{0};
 
-  // Make non-copyable to avoid atomic copy issues
+  // Holds the job back until its deadline when submitted with SubmitAt.
+  TimerWheelEntry Timer;
+
+  // Result of a SubmitWithResult job, in ResultStorage or the caller's
+  // buffer. The job and its JobFuture each hold a reference; the slot is
+  // recycled once both are gone.
+  void *Result{nullptr};
+  void (*DestroyResult)(void *storage) noexcept {nullptr};
+  std::atomic<u32> ResultReferences{0};
+  alignas(JobResultAlignment) unsigned char ResultStorage[JobResultCapacity];
+
+  Job() noexcept = default;
+
+  // Queues hold raw pointers, so jobs stay put once created
   Job(const Job &) = delete;
   Job &operator=(const Job &) = delete;
+};
 
-  // Allow move operations
-  Job(Job &&other) noexcept
-      : Function(std::move(other.Function)), Priority(other.Priority),
-        Cat(other.Cat), Handle(other.Handle),
-        Dependencies(std::move(other.Dependencies)),
-        Completed(other.Completed.load()) {}
-
-  Job &operator=(Job &&other) noexcept {
-    if (this != &other) {
-      Function = std::move(other.Function);
-      Priority = other.Priority;
-      Cat = other.Cat;
-      Handle = other.Handle;
-      Dependencies = std::move(other.Dependencies);
-      Completed.store(other.Completed.load());
-    }
-    return *this;
-  }
+// How worker threads are placed on the machine.
+enum class WorkerPinning : u8 {
+  None,            // Let the OS schedule workers anywhere (default)
+  Cores,           // One worker per physical core, pinned to that core
+  HardwareThreads, // One worker per logical CPU, pinned to that CPU
+};
+
+struct WorkerGroupConfig {
+  // Threads dedicated to the group. A group without threads hands its jobs
+  // to Compute; for Compute itself 0 means one per CPU (or pinning unit).
+  u32 ThreadCount{0};
+  // Extra threads that only run while workers of the group are stuck in
+  // JobFlags::Blocking jobs, so blocking work does not starve the group.
+  u32 CompensationThreads{0};
+  // Threads the group may add on top of ThreadCount while its jobs queue up,
+  // and retire again once idle; see WorkerScalingPolicy.
+  u32 ElasticThreads{0};
+};
+
+// What a worker does when it runs out of jobs. It busy-waits with CpuRelax
+// for SpinNs, yields its time slice YieldCount times, then parks until a
+// submit wakes it. Spinning hides wake-up latency for bursty work; parking
+// keeps an idle pool off the CPU.
+struct WorkerIdlePolicy {
+  u32 SpinNs{20000};
+  u32 YieldCount{4};
+};
+
+// When elastic threads (WorkerGroupConfig::ElasticThreads) come and go. A
+// group whose jobs have found no idle worker for ScaleUpWaitNs starts one,
+// and keeps adding one per ScaleUpWaitNs while that lasts. An elastic worker
+// that stays parked for RetireIdleNs exits its thread.
+struct WorkerScalingPolicy {
+  u64 ScaleUpWaitNs{time::MillisecondsToNs(1)};
+  u64 RetireIdleNs{time::SecondsToNs(2)};
+  // Keep Compute within the cgroup v2 cpu.max quota (see DetectCpuQuota):
+  // it caps an auto-detected thread count at Init, and elastic growth and
+  // retirement follow the quota as it changes. A throttled container that
+  // runs more busy threads than its quota stalls all of them at once.
+  bool RespectCpuQuota{true};
+};
+
+// When a submitted job runs in place on the submitting thread instead of
+// being queued (work-first): enqueueing behind a deep backlog only grows the
+// queue and leaves the submitter waiting with nothing to do. Only jobs that
+// are ready at submission qualify, and only while nothing of higher priority
+// waits in their group. Jobs for a registered thread or marked Blocking are
+// always queued, as are jobs for another group than the submitting worker's.
+struct WorkerInlinePolicy {
+  // Run in place once this many jobs of the same priority are queued where
+  // the job would go (the worker's own deque, or the injection queue for
+  // other threads); 0 never does.
+  u32 QueueDepth{256};
+  // Run JobFlags::Cheap jobs in place whatever the queue depth.
+  bool CheapJobs{true};
+  // Jobs run in place may submit more; beyond this nesting they are queued,
+  // which bounds the stack.
+  u32 MaxDepth{8};
+};
+
+struct JobSystemStats {
+  // Heap allocations made on the submit path (dependency overflow edges,
+  // large resource sets and job functions too big for their inline buffer).
+  u64 HeapAllocations{0};
+  // Submits that found the job pool empty and had to wait for a free slot.
+  u64 PoolExhaustedWaits{0};
+  // Times a worker used up its spin and yield budget and parked.
+  u64 WorkerParks{0};
+  // Jobs dropped without running because they or a dependency were
+  // cancelled.
+  u64 JobsCancelled{0};
+  // Elastic worker threads started and retired.
+  u64 WorkersStarted{0};
+  u64 WorkersRetired{0};
+  // Jobs run in place on the submitting thread (see WorkerInlinePolicy).
+  u64 JobsRunInline{0};
+};
+
+// Submit-to-start wait and run time of a set of jobs.
+struct JobLatencyStats {
+  LatencyHistogram Wait;
+  LatencyHistogram Run;
+};
+
+struct CategoryLatencyStats {
+  Category Cat{};
+  JobLatencyStats Latency;
+};
+
+struct WorkerStats {
+  u64 JobsExecuted{0};
+  u64 JobsStolen{0};
+  u64 BusyNs{0};
+};
+
+// Cumulative counters since Init, see ThreadPoolJobSystem::Telemetry().
+struct JobSystemTelemetry {
+  u64 UptimeNs{0};
+  std::vector<WorkerStats> Workers;
+  // Jobs run by non-worker threads while they wait or call ProcessJobs.
+  WorkerStats External;
+  JobLatencyStats ByPriority[3];
+  // The first few categories each worker sees; uncategorized jobs are only
+  // counted per priority.
+  std::vector<CategoryLatencyStats> ByCategory;
+  // Jobs queued but not started, per priority, at the time of the snapshot.
+  u64 QueueDepth[3]{};
 };
 
+// Work-stealing thread pool. Every worker owns a Chase-Lev deque per priority:
+// jobs submitted from a worker go to the bottom of its own deque, idle workers
+// steal from the top of their peers' deques, and submits from non-worker
+// threads go through a shared lock-free injection queue. Dependencies are
+// tracked with per-job counters and successor lists, so only runnable jobs are
+// ever queued. Jobs live in a fixed pool sized by SetJobCapacity; a handle
+// encodes its slot index and generation, so IsComplete is one atomic load.
+// Jobs for a registered thread skip the workers and go to a queue only that
+// thread drains. Delayed and periodic jobs wait in a timer wheel that a
+// dedicated timer thread advances, sleeping until the next deadline. The
+// same thread starts elastic workers when a group falls behind.
 class ThreadPoolJobSystem final : public IJobSystem {
 public:
-  ThreadPoolJobSystem() = default;
-  virtual ~ThreadPoolJobSystem() = default;
+  ThreadPoolJobSystem() noexcept;
+  virtual ~ThreadPoolJobSystem();
 
   virtual JobHandle Submit(JobFunction job,
                            JobPriority priority = JobPriority::Normal,
@@ -61,48 +221,257 @@ public:
                            u32 dependencyCount,
                            JobPriority priority = JobPriority::Normal,
                            Category category = Category{0}) noexcept override;
+  virtual void SubmitBatch(JobDesc *jobs, u32 count,
+                           JobHandle *outHandles) noexcept override;
+  virtual JobHandle SubmitAt(JobDesc desc,
+                             u64 deadlineNs) noexcept override;
+
+  // Each periodic job keeps one job slot for its next run.
+  static constexpr u32 MaxPeriodicJobs = 64;
+  virtual PeriodicJob SubmitPeriodic(JobDesc desc,
+                                     u64 periodNs) noexcept override;
+  virtual void CancelPeriodic(PeriodicJob job) noexcept override;
+
+  // Declared resources (JobDesc::Reads/Writes) hash into ResourceSlotCount
+  // slots, and resources sharing a slot are ordered as if they were one:
+  // always safe, rarely stricter than needed. Each slot tracks up to
+  // ResourceReaderSlots concurrent readers; a reader beyond that also waits
+  // for the one whose place it takes.
+  static constexpr u32 ResourceSlotCount = 1024;
+  static constexpr u32 ResourceReaderSlots = 8;
+
+  virtual JobHandle SubmitHeld(JobDesc desc) noexcept override;
+  virtual bool AddHold(JobHandle handle) noexcept override;
+  virtual void ReleaseHold(JobHandle handle) noexcept override;
+
+  // A result stored in the job slot keeps the slot, and so counts against
+  // the job capacity, until its future is released.
+  virtual JobHandle SubmitWithResult(JobDesc desc,
+                                     const JobResultDesc &result,
+                                     void *&outStorage) noexcept override;
+  virtual void ReleaseResult(JobHandle handle, void *storage,
+                             const JobResultDesc &result) noexcept override;
+
   virtual void Wait(JobHandle handle) noexcept override;
   virtual void WaitAll(const JobHandle *handles, u32 count) noexcept override;
   virtual bool IsComplete(JobHandle handle) noexcept override;
   virtual u32 WorkerThreadCount() const noexcept override;
   virtual void ProcessJobs(u32 maxJobs = 1) noexcept override;
 
+  // Up to MaxJobThreads threads; each gets a queue holding up to the job
+  // capacity.
+  static constexpr u32 MaxJobThreads = 8;
+  virtual JobThread RegisterThread() noexcept override;
+
   virtual bool Init() noexcept override;
   virtual void Shutdown() noexcept override;
 
+  // Compute thread count; same as SetWorkerGroup(Compute, {count, ...}).
   void SetWorkerThreadCount(u32 count) noexcept {
-    m_RequestedWorkerCount = count;
+    m_GroupConfigs[GroupIndex(WorkerGroup::Compute)].ThreadCount = count;
+  }
+
+  // Each group has its own threads and queues and never steals from another
+  // group, so blocking I/O jobs cannot hold up compute workers. By default
+  // Compute has one thread per CPU, Io one thread and Realtime none. Must be
+  // called before Init.
+  void SetWorkerGroup(WorkerGroup group,
+                      const WorkerGroupConfig &config) noexcept;
+
+  // Jobs of `category` submitted with WorkerGroup::Default go to `group`.
+  // Up to MaxCategoryRoutes categories. Must be called before Init.
+  static constexpr u32 MaxCategoryRoutes = 16;
+  bool RouteCategory(Category category, WorkerGroup group) noexcept;
+
+  // With pinning enabled, Init reads the CPU topology, pins each worker and
+  // makes idle workers steal from peers on their own last-level cache first.
+  // An auto-detected worker count then follows the pinning unit. Must be
+  // called before Init.
+  void SetWorkerPinning(WorkerPinning pinning) noexcept {
+    m_Pinning = pinning;
+  }
+
+  // Must be called before Init.
+  void SetIdlePolicy(const WorkerIdlePolicy &policy) noexcept {
+    m_IdlePolicy = policy;
+  }
+
+  // Must be called before Init.
+  void SetInlinePolicy(const WorkerInlinePolicy &policy) noexcept {
+    m_InlinePolicy = policy;
+  }
+
+  // Must be called before Init.
+  void SetScalingPolicy(const WorkerScalingPolicy &policy) noexcept {
+    m_ScalingPolicy = policy;
+  }
+
+  // Maximum number of jobs in flight (submitted but not yet finished).
+  // Rounded up to a power of two. Must be called before Init.
+  void SetJobCapacity(u32 capacity) noexcept;
+
+  JobSystemStats Stats() const noexcept;
+
+  // Threads of a group, not counting compensation or elastic threads.
+  u32 WorkerGroupThreadCount(WorkerGroup group) const noexcept;
+
+  // Threads of a group running right now, including elastic ones but not
+  // compensation threads.
+  u32 ActiveWorkerCount(WorkerGroup group) const noexcept;
+
+  // Every executed job is recorded in per-worker counters and latency
+  // histograms (a couple of clock reads and relaxed increments). Telemetry()
+  // merges them into a snapshot and may allocate. Every `intervalNs` one
+  // worker also emits utilization, queue depth, steal counts and latency
+  // percentiles for that interval as profiler counters; 0 turns the
+  // counters off. Must be called before Init.
+  void SetTelemetryInterval(u64 intervalNs) noexcept {
+    m_TelemetryIntervalNs = intervalNs;
   }
+  JobSystemTelemetry Telemetry() const noexcept;
 
 private:
-  struct JobCompare {
-    bool operator()(const std::shared_ptr<Job> &a,
-                    const std::shared_ptr<Job> &b) const {
-      // Higher priority jobs should come first (reverse order for
-      // priority_queue)
-      return static_cast<int>(a->Priority) < static_cast<int>(b->Priority);
-    }
-  };
+  struct Worker;
+  struct Group;
+  struct JobThreadState;
+  struct PeriodicState;
+  struct ResourceSlot;
+
+  static constexpr u32 PriorityCount = 3;
+  static constexpr u32 GroupCount = 3; // Compute, Io, Realtime
+
+  static constexpr u32 GroupIndex(WorkerGroup group) noexcept {
+    return group == WorkerGroup::Default ? 0
+                                         : static_cast<u32>(group) - 1;
+  }
+
+  void WorkerThreadFunction(Worker *worker) noexcept;
+  // False once an elastic worker has idled long enough to retire.
+  bool Idle(Worker *worker) noexcept;
+  bool Park(Worker *worker) noexcept;
+  bool ShouldRetire(Group &group) noexcept;
+  void RequestScaleCheck(Group &group) noexcept;
+  void ScaleGroup(Group &group) noexcept;
+  bool StartElasticWorker(Group &group) noexcept;
+  void GoDormant(Worker *worker) noexcept;
+  bool IsSpareNeeded(const Worker *worker) const noexcept;
+  void BeginBlocking(Group &group) noexcept;
+  void EndBlocking(Group &group) noexcept;
+  void PlaceWorkers();
+  void BuildStealOrder() noexcept;
+  Job *GetNextReadyJob(Worker *self) noexcept;
+  Job *TakeJob(Group &group, u32 priority, Worker *self) noexcept;
+  bool StealJob(Group &group, u32 priority, Worker *self, Job *&out) noexcept;
+  u8 ResolveGroup(WorkerGroup group, Category category) const noexcept;
+  Job *PrepareJob(JobDesc &desc,
+                  const JobResultDesc *result = nullptr) noexcept;
+  bool ReleaseSubmitReference(Job *job) noexcept;
+  void Enqueue(Job *job) noexcept;
+  // For jobs that are ready at submission: runs them in place when the
+  // inline policy allows, otherwise queues them like Enqueue.
+  void Dispatch(Job *job) noexcept;
+  bool ShouldRunInline(const Job *job) const noexcept;
+  void RunInline(Job *job) noexcept;
+  void PushReady(Job *job) noexcept;
+  void PushToThread(Job *job) noexcept;
+  void WakeWorkers(Group &group, u32 count) noexcept;
+  void WakeAllGroups(bool onlyWithWork) noexcept;
+  bool HasQueuedJobs(const Group &group) const noexcept;
+  bool HasBacklog(const Group &group) const noexcept;
+  void Execute(Job *job) noexcept;
+  bool IsCancelled(const Job *job) const noexcept;
+  void CompleteJob(Job *job, bool cancelled) noexcept;
+  bool AddSuccessor(JobHandle dependency, Job *successor,
+                    JobDependencyEdge *edge) noexcept;
+  Job *ResolveHandle(JobHandle handle, u32 &generation) const noexcept;
+  Job *AcquireJob() noexcept;
+  void ReleaseJob(Job *job) noexcept;
+  void RecycleJob(Job *job) noexcept;
+  Worker *CurrentWorker() const noexcept;
+  JobHandle MakeHandle(const Job *job) const noexcept;
+  void BlockUntilComplete(Job *job, u32 generation) noexcept;
+  JobThreadState *CurrentJobThread() const noexcept;
+  void BlockJobThread(JobThreadState &thread, Job *job,
+                      u32 generation) noexcept;
+  void WakeJobThreads(Job *job) noexcept;
+  // Blocks a worker in Wait until the job completes or its group gets work.
+  void BlockWorker(Worker &worker, Job *job, u32 generation) noexcept;
+  void WakeBlockedWorkers(Job *job) noexcept;
+  void RecordJob(Worker *self, const Job *job, u64 startNs,
+                 u64 endNs) noexcept;
+  void CollectTelemetry(JobSystemTelemetry &out) const noexcept;
+  void EmitTelemetry(u64 nowNs) noexcept;
+  void TimerThreadFunction() noexcept;
+  bool ArmTimer(Job *job, u64 deadlineNs) noexcept;
+  void ReleaseTimers(TimerWheelEntry *expired) noexcept;
+  u32 InferDependencies(const JobDesc &desc, JobHandle self,
+                        JobHandle *out) noexcept;
+  void RunPeriodic(PeriodicState &state) noexcept;
+  void SchedulePeriodic(PeriodicState &state) noexcept;
 
-  void WorkerThreadFunction() noexcept;
-  std::shared_ptr<Job> GetNextReadyJob() noexcept;
-  bool AreJobDependenciesComplete(const std::shared_ptr<Job> &job) noexcept;
-  JobHandle GenerateJobHandle() noexcept;
+  Job *m_Jobs{nullptr};
+  u32 m_JobCapacity{4096};
+  // Treiber stack of free slots: ABA tag in the high half, index + 1 below.
+  std::atomic<u64> m_FreeJobs{0};
 
-  mutable std::mutex m_Mutex;
-  std::condition_variable m_JobAvailable;
-  std::condition_variable m_JobCompleted;
+  // Groups that have threads; jobs for the others go to Compute.
+  std::unique_ptr<Group> m_Groups[GroupCount];
+  WorkerGroupConfig m_GroupConfigs[GroupCount]{
+      {0, 0, 0}, {1, 1, 0}, {0, 0, 0}};
+
+  struct CategoryRoute {
+    u32 CategoryId{0};
+    u8 Group{0};
+  };
+  CategoryRoute m_CategoryRoutes[MaxCategoryRoutes]{};
+  u32 m_CategoryRouteCount{0};
 
-  std::priority_queue<std::shared_ptr<Job>, std::vector<std::shared_ptr<Job>>,
-                      JobCompare>
-      m_JobQueue;
-  std::unordered_map<u64, std::shared_ptr<Job>> m_ActiveJobs;
+  // Registered threads; entries below m_JobThreadCount are immutable.
+  std::unique_ptr<JobThreadState> m_JobThreads[MaxJobThreads];
+  std::atomic<u32> m_JobThreadCount{0};
+  std::mutex m_RegisterMutex;
 
-  std::vector<std::thread> m_WorkerThreads;
+  // Every worker of every group; a group's workers are contiguous.
+  std::vector<std::unique_ptr<Worker>> m_Workers;
   std::atomic<bool> m_Shutdown{false};
-  std::atomic<u64> m_NextJobId{1};
 
-  u32 m_RequestedWorkerCount{0}; // 0 = auto-detect
+  // The wheel, the periodic slots and the timer thread's state are guarded by
+  // m_TimerMutex.
+  std::mutex m_TimerMutex;
+  std::condition_variable m_TimerWake;
+  std::unique_ptr<TimerWheel> m_TimerWheel;
+  std::unique_ptr<PeriodicState[]> m_Periodic;
+  // Deadline the timer thread sleeps until; 0 while it is awake.
+  u64 m_TimerWakeNs{0};
+  bool m_TimerStop{false};
+  std::thread m_TimerThread;
+
+  // Last writer and current readers per resource slot.
+  std::unique_ptr<ResourceSlot[]> m_Resources;
+  std::mutex m_ResourceMutex;
+
+  std::atomic<u64> m_HeapAllocations{0};
+  std::atomic<u64> m_PoolExhaustedWaits{0};
+  std::atomic<u64> m_WorkerParks{0};
+  std::atomic<u64> m_JobsCancelled{0};
+  std::atomic<u64> m_WorkersStarted{0};
+  std::atomic<u64> m_WorkersRetired{0};
+  std::atomic<u64> m_JobsRunInline{0};
+
+  std::unique_ptr<WorkerTelemetry> m_ExternalTelemetry;
+  u64 m_InitNs{0};
+  u64 m_TelemetryIntervalNs{time::MillisecondsToNs(100)};
+  std::atomic<u64> m_NextTelemetryNs{0};
+  std::atomic_flag m_EmittingTelemetry;
+  // Snapshots from the last two emissions; the counters report the
+  // difference. Kept around so emitting does not allocate.
+  std::unique_ptr<JobSystemTelemetry> m_TelemetryCurrent;
+  std::unique_ptr<JobSystemTelemetry> m_TelemetryPrevious;
+
+  WorkerPinning m_Pinning{WorkerPinning::None};
+  WorkerIdlePolicy m_IdlePolicy{};
+  WorkerScalingPolicy m_ScalingPolicy{};
+  WorkerInlinePolicy m_InlinePolicy{};
   bool m_Initialized{false};
 };
 
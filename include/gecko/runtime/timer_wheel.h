@@ -0,0 +1,73 @@
+#pragma once
+
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// Intrusive node of a TimerWheel. The owner embeds it in whatever it wants
+// woken up and keeps it alive while linked.
+struct TimerWheelEntry {
+  u64 DeadlineNs{0};
+  // What the entry belongs to; the wheel never touches it.
+  void *Context{nullptr};
+
+  TimerWheelEntry *Next{nullptr};
+  // Link that points at this entry, null while unlinked.
+  TimerWheelEntry **Prev{nullptr};
+  u32 Bucket{0};
+
+  bool IsLinked() const noexcept { return Prev != nullptr; }
+};
+
+// Hierarchical timer wheel over MonotonicTimeNs deadlines. Time advances in
+// ticks of 2^TickShift ns. Level 0 has one slot per tick, and each higher
+// level has slots SlotCount times coarser, so insert and remove are O(1).
+// Entries move down a level when their slot comes up. Entries beyond the top
+// level wait on an overflow list until the top level wraps. An entry expires
+// on the first tick that starts at or after its deadline, so it is never
+// early. Not thread-safe; the owner serializes access.
+class TimerWheel {
+public:
+  static constexpr u32 TickShift = 14; // ~16 us
+  static constexpr u32 SlotBits = 6;
+  static constexpr u32 SlotCount = 1u << SlotBits;
+  static constexpr u32 LevelCount = 5; // ~4.9 hours before overflow
+  static constexpr u64 NoDeadline = ~u64{0};
+
+  explicit TimerWheel(u64 nowNs = 0) noexcept;
+
+  TimerWheel(const TimerWheel &) = delete;
+  TimerWheel &operator=(const TimerWheel &) = delete;
+
+  // Deadlines already in the past expire on the next Advance.
+  void Insert(TimerWheelEntry *entry) noexcept;
+  void Remove(TimerWheelEntry *entry) noexcept;
+
+  // Unlinks every entry due by `nowNs` and returns them as a list chained
+  // through Next, in no particular order.
+  TimerWheelEntry *Advance(u64 nowNs) noexcept;
+
+  // When Advance next has work to do (an expiry or moving entries down a
+  // level), or NoDeadline when empty.
+  u64 NextDeadlineNs() const noexcept;
+
+  bool Empty() const noexcept { return m_Count == 0; }
+
+private:
+  static constexpr u32 OverflowBucket = LevelCount * SlotCount;
+
+  void Place(TimerWheelEntry *entry) noexcept;
+  void Link(TimerWheelEntry *entry, u32 bucket) noexcept;
+  TimerWheelEntry *TakeBucket(u32 bucket) noexcept;
+  void ProcessTick(u64 tick, TimerWheelEntry *&expired) noexcept;
+  u64 NextEventTick() const noexcept;
+
+  // Index OverflowBucket is the overflow list.
+  TimerWheelEntry *m_Buckets[LevelCount * SlotCount + 1]{};
+  u64 m_Occupied[LevelCount]{};
+  // First tick not processed yet.
+  u64 m_CurrentTick{0};
+  u32 m_Count{0};
+};
+
+} // namespace gecko::runtime
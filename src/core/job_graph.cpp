@@ -0,0 +1,269 @@
+#include "gecko/core/job_graph.h"
+
+#include <algorithm>
+
+#include "gecko/core/assert.h"
+#include "gecko/core/hash.h"
+#include "gecko/core/log.h"
+#include "gecko/core/profiler.h"
+#include "gecko/core/time.h"
+
+namespace gecko {
+
+JobGraph::JobGraph(const char *name, Category category) noexcept
+    : m_Name(name ? name : "JobGraph"), m_Category(category) {}
+
+JobGraph::~JobGraph() {
+  GECKO_ASSERT(IsComplete() && "Destroying a JobGraph that is still running");
+}
+
+JobGraph::NodeId JobGraph::AddNode(const char *name, JobFunction function,
+                                   JobPriority priority,
+                                   Category category) noexcept {
+  GECKO_ASSERT(IsComplete() && "Cannot modify a running JobGraph");
+  GECKO_ASSERT(function && "JobGraph node needs a function");
+
+  try {
+    Node node;
+    node.Name = name ? name : "JobGraph::Node";
+    node.Function = std::move(function);
+    node.Priority = priority;
+    node.Cat = category;
+    m_Nodes.push_back(std::move(node));
+  } catch (...) {
+    return InvalidNode;
+  }
+
+  m_Compiled = false;
+  return static_cast<NodeId>(m_Nodes.size() - 1);
+}
+
+bool JobGraph::AddEdge(NodeId before, NodeId after) noexcept {
+  GECKO_ASSERT(IsComplete() && "Cannot modify a running JobGraph");
+  if (before >= m_Nodes.size() || after >= m_Nodes.size() || before == after)
+    return false;
+
+  try {
+    m_EdgeFrom.push_back(before);
+    m_EdgeTo.push_back(after);
+  } catch (...) {
+    m_EdgeFrom.resize(m_EdgeTo.size());
+    return false;
+  }
+
+  m_Compiled = false;
+  return true;
+}
+
+bool JobGraph::Compile() noexcept {
+  GECKO_ASSERT(IsComplete() && "Cannot compile a running JobGraph");
+  m_Compiled = false;
+
+  const u32 nodeCount = NodeCount();
+  const size_t edgeCount = m_EdgeFrom.size();
+
+  try {
+    // Flatten successor lists (CSR) and count incoming edges
+    for (Node &node : m_Nodes) {
+      node.DependencyCount = 0;
+      node.SuccessorCount = 0;
+    }
+    for (size_t i = 0; i < edgeCount; ++i) {
+      ++m_Nodes[m_EdgeFrom[i]].SuccessorCount;
+      ++m_Nodes[m_EdgeTo[i]].DependencyCount;
+    }
+
+    u32 offset = 0;
+    for (Node &node : m_Nodes) {
+      node.FirstSuccessor = offset;
+      offset += node.SuccessorCount;
+    }
+
+    m_Successors.assign(edgeCount, InvalidNode);
+    std::vector<u32> filled(nodeCount, 0);
+    for (size_t i = 0; i < edgeCount; ++i) {
+      Node &from = m_Nodes[m_EdgeFrom[i]];
+      m_Successors[from.FirstSuccessor + filled[m_EdgeFrom[i]]++] =
+          m_EdgeTo[i];
+    }
+
+    // Kahn's algorithm: anything left unsorted sits on a cycle
+    m_Roots.clear();
+    m_Order.clear();
+    m_Order.reserve(nodeCount);
+    std::vector<u32> pending(nodeCount);
+    for (NodeId id = 0; id < nodeCount; ++id) {
+      pending[id] = m_Nodes[id].DependencyCount;
+      if (pending[id] == 0) {
+        m_Roots.push_back(id);
+        m_Order.push_back(id);
+      }
+    }
+    for (size_t i = 0; i < m_Order.size(); ++i) {
+      const Node &node = m_Nodes[m_Order[i]];
+      for (u32 s = 0; s < node.SuccessorCount; ++s) {
+        const NodeId successor = m_Successors[node.FirstSuccessor + s];
+        if (--pending[successor] == 0)
+          m_Order.push_back(successor);
+      }
+    }
+    if (m_Order.size() != nodeCount)
+      return false;
+
+    m_Pending = nodeCount > 0 ? std::make_unique<std::atomic<u32>[]>(nodeCount)
+                              : nullptr;
+    m_PathNs.assign(nodeCount, 0);
+    m_PathPrevious.assign(nodeCount, InvalidNode);
+    m_CriticalPath.clear();
+    m_CriticalPath.reserve(nodeCount);
+  } catch (...) {
+    return false;
+  }
+
+  m_Compiled = true;
+  return true;
+}
+
+JobHandle JobGraph::Run() noexcept {
+  GECKO_ASSERT(m_Compiled && "JobGraph must be compiled before running");
+  GECKO_ASSERT(IsComplete() && "JobGraph is already running");
+  if (!m_Compiled || m_Nodes.empty())
+    return JobHandle{};
+
+  GECKO_PROF_SCOPE(m_Category, "JobGraph::Run");
+
+  // Without a sink to hold the run open, Launch runs every node in place.
+  m_Sink = JobHandle{};
+  if (IJobSystem *jobSystem = GetJobSystem()) {
+    JobDesc sink;
+    sink.Cat = m_Category;
+    m_Sink = jobSystem->SubmitHeld(std::move(sink));
+  }
+  const JobHandle sink = m_Sink;
+
+  for (NodeId id = 0; id < NodeCount(); ++id)
+    m_Pending[id].store(m_Nodes[id].DependencyCount,
+                        std::memory_order_relaxed);
+
+  // One extra count keeps the run open until FinishRun is done with the
+  // per-node timings.
+  m_Remaining.store(NodeCount() + 1, std::memory_order_release);
+
+  for (NodeId root : m_Roots)
+    Launch(root);
+  return sink;
+}
+
+void JobGraph::Wait() noexcept {
+  if (IsComplete())
+    return;
+
+  GECKO_PROF_SCOPE(m_Category, "JobGraph::Wait");
+  if (IJobSystem *jobSystem = GetJobSystem())
+    jobSystem->Wait(m_Sink);
+}
+
+bool JobGraph::IsComplete() const noexcept {
+  return m_Remaining.load(std::memory_order_acquire) == 0;
+}
+
+void JobGraph::Launch(NodeId node) noexcept {
+  IJobSystem *jobSystem = GetJobSystem();
+  if (m_Sink.IsValid() && jobSystem && jobSystem->WorkerThreadCount() > 0) {
+    const Node &info = m_Nodes[node];
+    JobHandle handle = jobSystem->Submit([this, node]() { RunNode(node); },
+                                         info.Priority, info.Cat);
+    if (handle.IsValid())
+      return;
+  }
+
+  // No workers (or the job system refused): run it right here
+  RunNode(node);
+}
+
+void JobGraph::RunNode(NodeId node) noexcept {
+  Node &info = m_Nodes[node];
+
+  // Same clock the profiler uses, so the path lines up with the zones
+  info.StartNs = MonotonicTimeNs();
+  try {
+    GECKO_PROF_SCOPE(info.Cat, info.Name);
+    info.Function();
+  } catch (...) {
+    // Like a plain job that throws: log it and let the run carry on, so
+    // successors still start and Wait still returns
+    GECKO_ERROR(info.Cat, "JobGraph %s: node %s threw an exception", m_Name,
+                info.Name);
+  }
+  info.EndNs = MonotonicTimeNs();
+
+  for (u32 s = 0; s < info.SuccessorCount; ++s) {
+    const NodeId successor = m_Successors[info.FirstSuccessor + s];
+    if (m_Pending[successor].fetch_sub(1, std::memory_order_acq_rel) == 1)
+      Launch(successor);
+  }
+
+  if (m_Remaining.fetch_sub(1, std::memory_order_acq_rel) == 2)
+    FinishRun();
+}
+
+void JobGraph::FinishRun() noexcept {
+  EmitCriticalPath();
+
+  // Once m_Remaining reads 0 the graph may be rerun or destroyed
+  const JobHandle sink = m_Sink;
+  m_Remaining.store(0, std::memory_order_release);
+  if (IJobSystem *jobSystem = GetJobSystem(); jobSystem && sink.IsValid())
+    jobSystem->ReleaseHold(sink);
+}
+
+void JobGraph::EmitCriticalPath() noexcept {
+  // Longest chain by node duration, walking nodes in topological order
+  std::fill(m_PathNs.begin(), m_PathNs.end(), 0);
+  std::fill(m_PathPrevious.begin(), m_PathPrevious.end(), InvalidNode);
+
+  NodeId last = InvalidNode;
+  for (NodeId id : m_Order) {
+    const Node &node = m_Nodes[id];
+    const u64 duration =
+        node.EndNs > node.StartNs ? node.EndNs - node.StartNs : 0;
+    m_PathNs[id] += duration;
+
+    if (last == InvalidNode || m_PathNs[id] > m_PathNs[last])
+      last = id;
+
+    for (u32 s = 0; s < node.SuccessorCount; ++s) {
+      const NodeId successor = m_Successors[node.FirstSuccessor + s];
+      if (m_PathNs[id] > m_PathNs[successor]) {
+        m_PathNs[successor] = m_PathNs[id];
+        m_PathPrevious[successor] = id;
+      }
+    }
+  }
+
+  m_CriticalPath.clear();
+  for (NodeId id = last; id != InvalidNode; id = m_PathPrevious[id])
+    m_CriticalPath.push_back(id);
+  std::reverse(m_CriticalPath.begin(), m_CriticalPath.end());
+  m_CriticalPathNs = last != InvalidNode ? m_PathNs[last] : 0;
+
+  auto *profiler = GetProfiler();
+  if (!profiler)
+    return;
+
+  // The critical path gets its own track, keyed by the graph name, with the
+  // nodes at the times they actually ran.
+  const u32 track = FNV1a(m_Name);
+  for (NodeId id : m_CriticalPath) {
+    const Node &node = m_Nodes[id];
+    const u32 nameHash = FNV1a(node.Name);
+    profiler->Emit(ProfEvent{ProfEventKind::ZoneBegin, node.StartNs, track,
+                             m_Category, nameHash, node.Name, 0});
+    profiler->Emit(ProfEvent{ProfEventKind::ZoneEnd, node.EndNs, track,
+                             m_Category, nameHash, node.Name, 0});
+  }
+  GECKO_PROF_COUNTER(m_Category, "job_graph_critical_path_ns",
+                     m_CriticalPathNs);
+}
+
+} // namespace gecko
@@ -0,0 +1,47 @@
+#include "gecko/core/job_group.h"
+
+namespace gecko {
+
+JobGroup::~JobGroup() { Wait(); }
+
+void JobGroup::Wait() noexcept {
+  WaitForJob(m_Gate.load(std::memory_order_acquire));
+}
+
+JobHandle JobGroup::Handle() const noexcept {
+  return m_Gate.load(std::memory_order_acquire);
+}
+
+bool JobGroup::IsComplete() const noexcept {
+  return IsJobComplete(m_Gate.load(std::memory_order_acquire));
+}
+
+JobHandle JobGroup::AcquireGate() noexcept {
+  IJobSystem *jobSystem = GetJobSystem();
+  if (!jobSystem)
+    return JobHandle{};
+
+  // A running child holds the gate, so nested Run calls always get in here.
+  // Once the last hold is gone the gate has finished and the next child
+  // starts a new one; whoever installs it first wins.
+  JobHandle gate = m_Gate.load(std::memory_order_acquire);
+  while (!jobSystem->AddHold(gate)) {
+    const JobHandle fresh = jobSystem->SubmitHeld(JobDesc{});
+    if (!fresh.IsValid())
+      return JobHandle{};
+    if (m_Gate.compare_exchange_strong(gate, fresh, std::memory_order_acq_rel,
+                                       std::memory_order_acquire))
+      return fresh;
+    jobSystem->ReleaseHold(fresh);
+  }
+  return gate;
+}
+
+void JobGroup::ReleaseGate(JobHandle gate) noexcept {
+  if (!gate.IsValid())
+    return;
+  if (IJobSystem *jobSystem = GetJobSystem())
+    jobSystem->ReleaseHold(gate);
+}
+
+} // namespace gecko
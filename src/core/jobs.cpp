@@ -0,0 +1,136 @@
+#include "gecko/core/jobs.h"
+
+#include <algorithm>
+#include <atomic>
+
+#include "gecko/core/assert.h"
+#include "gecko/core/time.h"
+
+namespace gecko {
+
+namespace {
+
+// Chunks of roughly this cost amortise the submit/steal overhead while still
+// leaving plenty of pieces to balance.
+constexpr u64 TargetChunkNs = 20'000;
+// Calibration keeps doubling the probe until it has measured at least this.
+constexpr u64 CalibrationNs = 2'000;
+// Auto grain never leaves fewer than this many chunks per worker.
+constexpr u64 MinChunksPerWorker = 4;
+
+struct ParallelForState {
+  IJobSystem *JobSystem{nullptr};
+  ParallelForBody Body{nullptr};
+  void *Context{nullptr};
+  u64 Grain{1};
+  JobPriority Priority{JobPriority::Normal};
+  Category Cat{};
+  std::atomic<u64> Remaining{0};
+  // Held empty job the caller waits on; the piece that finishes the range
+  // releases it.
+  JobHandle Done{};
+};
+
+void RunRange(ParallelForState *state, u64 begin, u64 end) noexcept {
+  // Keep the front half and hand out the back half. Thieves take from the
+  // cold end of a deque, so they get the largest pieces first.
+  while (end - begin > state->Grain) {
+    const u64 mid = begin + (end - begin) / 2;
+    JobHandle handle = state->JobSystem->Submit(
+        [state, mid, end]() { RunRange(state, mid, end); }, state->Priority,
+        state->Cat);
+    if (!handle.IsValid())
+      break; // Could not hand it out; run the rest ourselves
+    end = mid;
+  }
+
+  state->Body(state->Context, begin, end);
+  // The caller may unwind the state as soon as the last piece reports back.
+  IJobSystem *jobSystem = state->JobSystem;
+  const JobHandle done = state->Done;
+  if (state->Remaining.fetch_sub(end - begin, std::memory_order_acq_rel) ==
+      end - begin)
+    jobSystem->ReleaseHold(done);
+}
+
+// Runs a growing prefix of the range on this thread to time it, advancing
+// `begin` past the iterations it ran, and derives a grain from the result.
+u64 CalibrateGrain(ParallelForBody body, void *context, u64 &begin, u64 end,
+                   u32 workerCount) noexcept {
+  u64 probe = 1;
+  u64 measured = 0;
+  u64 elapsed = 0;
+  while (begin < end && elapsed < CalibrationNs) {
+    const u64 count = std::min(probe, end - begin);
+    const u64 start = MonotonicTimeNs();
+    body(context, begin, begin + count);
+    elapsed += MonotonicTimeNs() - start;
+    begin += count;
+    measured += count;
+    probe *= 2;
+  }
+
+  if (begin == end)
+    return 1;
+
+  const u64 nsPerIteration = std::max<u64>(1, elapsed / measured);
+  const u64 costGrain = std::max<u64>(1, TargetChunkNs / nsPerIteration);
+  const u64 balanceGrain = std::max<u64>(
+      1, (end - begin) / (static_cast<u64>(workerCount) * MinChunksPerWorker));
+  return std::min(costGrain, balanceGrain);
+}
+
+} // namespace
+
+void ParallelForRange(u64 begin, u64 end, u64 grain, ParallelForBody body,
+                      void *context, JobPriority priority,
+                      Category category) noexcept {
+  GECKO_ASSERT(body && "ParallelFor needs a loop body");
+  if (begin >= end)
+    return;
+
+  IJobSystem *jobSystem = GetJobSystem();
+  const u32 workerCount = jobSystem ? jobSystem->WorkerThreadCount() : 0;
+  if (workerCount == 0) {
+    body(context, begin, end);
+    return;
+  }
+
+  if (grain == AutoGrain) {
+    grain = CalibrateGrain(body, context, begin, end, workerCount);
+    if (begin == end)
+      return;
+  }
+
+  if (end - begin <= grain) {
+    body(context, begin, end);
+    return;
+  }
+
+  JobDesc done;
+  done.Priority = priority;
+  done.Cat = category;
+  const JobHandle doneHandle = jobSystem->SubmitHeld(std::move(done));
+  if (!doneHandle.IsValid()) {
+    body(context, begin, end);
+    return;
+  }
+
+  ParallelForState state;
+  state.JobSystem = jobSystem;
+  state.Body = body;
+  state.Context = context;
+  state.Grain = grain;
+  state.Priority = priority;
+  state.Cat = category;
+  state.Remaining.store(end - begin, std::memory_order_relaxed);
+  state.Done = doneHandle;
+
+  RunRange(&state, begin, end);
+
+  // The state lives on our stack, so stay until every piece has reported
+  // back. Wait runs queued jobs in the meantime, then blocks.
+  jobSystem->Wait(doneHandle);
+}
+
+} // namespace gecko
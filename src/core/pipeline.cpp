@@ -0,0 +1,284 @@
+#include "gecko/core/pipeline.h"
+
+#include "gecko/core/assert.h"
+#include "gecko/core/log.h"
+#include "gecko/core/profiler.h"
+
+namespace gecko {
+
+Pipeline::Pipeline(const char *name, Category category) noexcept
+    : m_Name(name ? name : "Pipeline"), m_Category(category) {}
+
+Pipeline::~Pipeline() {
+  GECKO_ASSERT(IsComplete() && "Destroying a Pipeline that is still running");
+}
+
+bool Pipeline::AddStage(PipelineMode mode, PipelineStageFunction function,
+                        JobPriority priority) noexcept {
+  GECKO_ASSERT(IsComplete() && "Cannot modify a running Pipeline");
+  GECKO_ASSERT(function && "Pipeline stage needs a function");
+
+  try {
+    Stage stage;
+    // The first stage decides the order everything else sees.
+    stage.Mode = m_Stages.empty() ? PipelineMode::SerialInOrder : mode;
+    stage.Function = std::move(function);
+    stage.Priority = priority;
+    m_Stages.push_back(std::move(stage));
+  } catch (...) {
+    return false;
+  }
+  return true;
+}
+
+bool Pipeline::Run(u32 tokens) noexcept {
+  GECKO_ASSERT(IsComplete() && "Pipeline is already running");
+  GECKO_ASSERT(tokens > 0 && "Pipeline needs at least one token");
+  if (m_Stages.empty() || tokens == 0)
+    return false;
+
+  GECKO_PROF_SCOPE(m_Category, "Pipeline::Run");
+
+  const u32 stageCount = StageCount();
+  try {
+    if (m_SerialCount != stageCount) {
+      m_Serial = std::make_unique<SerialState[]>(stageCount);
+      m_SerialCount = stageCount;
+    }
+    m_Items.resize(tokens);
+    m_Dropped.resize(tokens);
+    m_Waiting.assign(static_cast<std::size_t>(stageCount) * tokens, 0);
+    m_FreeTokens.clear();
+    m_FreeTokens.reserve(tokens);
+    for (u32 token = tokens; token-- > 0;)
+      m_FreeTokens.push_back(token);
+  } catch (...) {
+    return false;
+  }
+
+  for (u32 stage = 0; stage < stageCount; ++stage) {
+    m_Serial[stage].Busy = false;
+    m_Serial[stage].NextSequence = 0;
+  }
+  m_Tokens = tokens;
+  m_NextSequence = 0;
+  m_InputDone = false;
+
+  IJobSystem *jobSystem = GetJobSystem();
+  if (!jobSystem || jobSystem->WorkerThreadCount() == 0) {
+    RunSerially();
+    return true;
+  }
+
+  // The sink is released by whichever item finishes the run
+  JobDesc sink;
+  sink.Cat = m_Category;
+  m_Sink = jobSystem->SubmitHeld(std::move(sink));
+  if (!m_Sink.IsValid()) {
+    RunSerially();
+    return true;
+  }
+
+  m_Running.store(true, std::memory_order_release);
+  u32 token = NoToken;
+  {
+    std::lock_guard<std::mutex> lock(m_Serial[0].Lock);
+    token = TakeInputToken();
+  }
+  Launch(token, 0);
+  return true;
+}
+
+void Pipeline::Wait() noexcept {
+  if (IsComplete())
+    return;
+
+  GECKO_PROF_SCOPE(m_Category, "Pipeline::Wait");
+  if (IJobSystem *jobSystem = GetJobSystem())
+    jobSystem->Wait(m_Sink);
+}
+
+bool Pipeline::IsComplete() const noexcept {
+  return !m_Running.load(std::memory_order_acquire);
+}
+
+void Pipeline::RunSerially() noexcept {
+  // No workers: one item at a time, straight through every stage
+  PipelineItem &item = m_Items[0];
+  for (u64 sequence = 0;; ++sequence) {
+    item = PipelineItem{sequence, 0};
+    if (!RunStage(0, item))
+      break;
+    for (u32 stage = 1; stage < StageCount(); ++stage) {
+      if (!RunStage(stage, item))
+        break;
+    }
+  }
+}
+
+void Pipeline::Launch(u32 token, u32 stage) noexcept {
+  if (IJobSystem *jobSystem = GetJobSystem()) {
+    JobHandle handle = jobSystem->Submit(
+        [this, token, stage]() { Resume(token, stage, true); },
+        m_Stages[stage].Priority, m_Category);
+    if (handle.IsValid())
+      return;
+  }
+
+  // The job system refused: run it right here
+  Resume(token, stage, true);
+}
+
+void Pipeline::Resume(u32 token, u32 stage, bool holdsStage) noexcept {
+  GECKO_PROF_SCOPE(m_Category, m_Name);
+  PipelineItem &item = m_Items[token];
+
+  if (stage == 0) {
+    // Only the holder of stage 0 touches m_NextSequence
+    item = PipelineItem{m_NextSequence++, token};
+    m_Dropped[token] = 0;
+    const bool more = RunStage(0, item);
+
+    u32 next = NoToken;
+    bool finished = false;
+    {
+      std::lock_guard<std::mutex> lock(m_Serial[0].Lock);
+      m_Serial[0].Busy = false;
+      if (more) {
+        next = TakeInputToken();
+      } else {
+        m_InputDone = true;
+        m_FreeTokens.push_back(token);
+        finished = m_FreeTokens.size() == m_Tokens;
+      }
+    }
+
+    // Read the next item while this one moves on
+    if (next != NoToken)
+      Launch(next, 0);
+    if (!more) {
+      if (finished)
+        FinishRun();
+      return;
+    }
+    stage = 1;
+    holdsStage = false;
+  }
+
+  for (; stage < StageCount(); ++stage, holdsStage = false) {
+    Stage &info = m_Stages[stage];
+    const bool serial = info.Mode != PipelineMode::Parallel;
+    // A busy serial stage (or, in order, one waiting for an earlier item)
+    // parks the item; whoever leaves the stage picks it up again.
+    if (serial && !holdsStage && !Enter(stage, token))
+      return;
+    // Dropped items skip the work but still take their turn
+    if (!m_Dropped[token] && !RunStage(stage, item))
+      m_Dropped[token] = 1;
+    if (serial)
+      Leave(stage);
+  }
+  Finish(token);
+}
+
+bool Pipeline::RunStage(u32 stage, PipelineItem &item) noexcept {
+  try {
+    return m_Stages[stage].Function(item);
+  } catch (...) {
+    // Like a plain job that throws: log it, and drop the item so it still
+    // takes its turn and the run can finish
+    GECKO_ERROR(m_Category, "Pipeline %s: stage %u threw on item %llu",
+                m_Name, stage, static_cast<unsigned long long>(item.Sequence));
+    return false;
+  }
+}
+
+bool Pipeline::Enter(u32 stage, u32 token) noexcept {
+  SerialState &state = m_Serial[stage];
+  std::lock_guard<std::mutex> lock(state.Lock);
+  const bool turn = m_Stages[stage].Mode != PipelineMode::SerialInOrder ||
+                    m_Items[token].Sequence == state.NextSequence;
+  if (state.Busy || !turn) {
+    m_Waiting[static_cast<std::size_t>(stage) * m_Tokens + token] = 1;
+    return false;
+  }
+  state.Busy = true;
+  return true;
+}
+
+void Pipeline::Leave(u32 stage) noexcept {
+  SerialState &state = m_Serial[stage];
+  const bool inOrder = m_Stages[stage].Mode == PipelineMode::SerialInOrder;
+  u32 next = NoToken;
+  {
+    std::lock_guard<std::mutex> lock(state.Lock);
+    if (inOrder)
+      ++state.NextSequence;
+
+    // In order: the item whose turn it is, if it is here yet. Otherwise the
+    // oldest one waiting.
+    u8 *waiting = &m_Waiting[static_cast<std::size_t>(stage) * m_Tokens];
+    u64 oldest = ~u64{0};
+    for (u32 token = 0; token < m_Tokens; ++token) {
+      if (!waiting[token])
+        continue;
+      const u64 sequence = m_Items[token].Sequence;
+      if (inOrder ? sequence == state.NextSequence : sequence < oldest) {
+        next = token;
+        oldest = sequence;
+        if (inOrder)
+          break;
+      }
+    }
+
+    // The stage stays busy and passes straight to the next item
+    if (next != NoToken)
+      waiting[next] = 0;
+    else
+      state.Busy = false;
+  }
+
+  if (next != NoToken)
+    Launch(next, stage);
+}
+
+void Pipeline::Finish(u32 token) noexcept {
+  u32 next = NoToken;
+  bool finished = false;
+  {
+    std::lock_guard<std::mutex> lock(m_Serial[0].Lock);
+    m_FreeTokens.push_back(token);
+    if (m_InputDone)
+      finished = m_FreeTokens.size() == m_Tokens;
+    else
+      next = TakeInputToken();
+  }
+
+  // Without a token in hand the run may end at any moment, so only the
+  // last item touches the pipeline after this.
+  if (next != NoToken)
+    Launch(next, 0);
+  else if (finished)
+    FinishRun();
+}
+
+void Pipeline::FinishRun() noexcept {
+  // The pipeline may be rerun or destroyed as soon as m_Running is cleared
+  const JobHandle sink = m_Sink;
+  m_Running.store(false, std::memory_order_release);
+  if (IJobSystem *jobSystem = GetJobSystem())
+    jobSystem->ReleaseHold(sink);
+}
+
+u32 Pipeline::TakeInputToken() noexcept {
+  // Caller holds stage 0's lock
+  SerialState &input = m_Serial[0];
+  if (input.Busy || m_InputDone || m_FreeTokens.empty())
+    return NoToken;
+  input.Busy = true;
+  const u32 token = m_FreeTokens.back();
+  m_FreeTokens.pop_back();
+  return token;
+}
+
+} // namespace gecko
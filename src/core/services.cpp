@@ -103,11 +103,75 @@ JobHandle NullJobSystem::Submit(JobFunction job, const JobHandle *dependencies,
   return JobHandle{};
 }
 
+void NullJobSystem::SubmitBatch(JobDesc *jobs, u32 count,
+                                JobHandle *outHandles) noexcept {
+  // Execute jobs immediately, in order
+  for (u32 i = 0; i < count; ++i) {
+    JobFunction job = std::move(jobs[i].Function);
+    const CancellationToken *token = jobs[i].Cancellation;
+    if (job && !(token && token->IsCancelled()))
+      job();
+    if (outHandles)
+      outHandles[i] = JobHandle{};
+  }
+}
+
+JobHandle NullJobSystem::SubmitAt(JobDesc desc, u64 deadlineNs) noexcept {
+  // No timer to hand it to, and sleeping out the deadline would block the
+  // caller: run it now, like any other job
+  JobHandle handle;
+  SubmitBatch(&desc, 1, &handle);
+  return handle;
+}
+
+PeriodicJob NullJobSystem::SubmitPeriodic(JobDesc desc,
+                                          u64 periodNs) noexcept {
+  return PeriodicJob{};
+}
+
+void NullJobSystem::CancelPeriodic(PeriodicJob job) noexcept {}
+
+JobHandle NullJobSystem::SubmitHeld(JobDesc desc) noexcept {
+  // Nothing to hold it in; run it now, like any other job
+  SubmitBatch(&desc, 1, nullptr);
+  return JobHandle{};
+}
+
+bool NullJobSystem::AddHold(JobHandle handle) noexcept { return false; }
+void NullJobSystem::ReleaseHold(JobHandle handle) noexcept {}
+
+JobHandle NullJobSystem::SubmitWithResult(JobDesc desc,
+                                          const JobResultDesc &result,
+                                          void *&outStorage) noexcept {
+  // No job slots to keep it in, so the result goes on the heap
+  void *storage = result.Buffer;
+  if (!storage)
+    storage = AllocBytes(result.Size, result.Alignment, Category{0});
+  outStorage = storage;
+  if (!storage)
+    return JobHandle{};
+
+  desc.Function = result.Bind(result.Context, storage);
+  JobHandle handle;
+  SubmitBatch(&desc, 1, &handle);
+  return handle;
+}
+
+void NullJobSystem::ReleaseResult(JobHandle handle, void *storage,
+                                  const JobResultDesc &result) noexcept {
+  if (!storage)
+    return;
+  result.Destroy(storage);
+  if (!result.Buffer)
+    DeallocBytes(storage, result.Size, result.Alignment, Category{0});
+}
+
 void NullJobSystem::Wait(JobHandle handle) noexcept {}
 void NullJobSystem::WaitAll(const JobHandle *handles, u32 count) noexcept {}
 bool NullJobSystem::IsComplete(JobHandle handle) noexcept { return true; }
 u32 NullJobSystem::WorkerThreadCount() const noexcept { return 0; }
 void NullJobSystem::ProcessJobs(u32 maxJobs) noexcept {}
+JobThread NullJobSystem::RegisterThread() noexcept { return JobThread{}; }
 bool NullJobSystem::Init() noexcept { return true; }
 void NullJobSystem::Shutdown() noexcept {}
 
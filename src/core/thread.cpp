@@ -8,6 +8,12 @@
 #include <intrin.h>
 #endif
 
+#if defined(__linux__)
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 #include "gecko/core/assert.h"
 #include "gecko/core/time.h"
 
@@ -22,6 +28,42 @@ u32 HardwareThreadCount() noexcept {
   return std::max(1u, std::thread::hardware_concurrency());
 }
 
+void CpuRelax() noexcept {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+  _mm_pause(); // x86/x64 pause instruction to reduce power and improve
+               // performance
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+  __builtin_ia32_pause();
+#endif
+}
+
+void SetCurrentThreadName(const char *name) noexcept {
+  if (!name)
+    return;
+#if defined(__linux__)
+  char truncated[16];
+  std::strncpy(truncated, name, sizeof(truncated) - 1);
+  truncated[sizeof(truncated) - 1] = '\0';
+  pthread_setname_np(pthread_self(), truncated);
+#endif
+}
+
+bool PinCurrentThread(const u32 *cpus, u32 count) noexcept {
+  if (!cpus || count == 0)
+    return false;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (u32 i = 0; i < count; ++i) {
+    if (cpus[i] < CPU_SETSIZE)
+      CPU_SET(cpus[i], &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+  return false;
+#endif
+}
+
 void SpinWaitNs(u64 nanoseconds) noexcept {
   GECKO_ASSERT(nanoseconds > 0 && "Spin wait duration must be greater than 0");
 
@@ -29,14 +71,7 @@ void SpinWaitNs(u64 nanoseconds) noexcept {
   u64 target = start + nanoseconds;
 
   while (HighResTimeNs() < target) {
-    // Busy wait - intentionally empty
-    // On some architectures, you might want to add a pause instruction here
-#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
-    _mm_pause(); // x86/x64 pause instruction to reduce power and improve
-                 // performance
-#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
-    __builtin_ia32_pause();
-#endif
+    CpuRelax();
   }
 }
 
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "gecko/core/assert.h"
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// Bounded lock-free multi-producer/multi-consumer queue (Vyukov). Each cell
+// carries a sequence number that tells producers and consumers whether it is
+// free or filled for their lap, so neither side ever takes a lock.
+template <typename T> class BoundedMpmcQueue {
+public:
+  explicit BoundedMpmcQueue(u32 capacityPow2)
+      : m_Cells(std::make_unique<Cell[]>(capacityPow2)),
+        m_Mask(capacityPow2 - 1) {
+    GECKO_ASSERT(capacityPow2 > 0 &&
+                 (capacityPow2 & (capacityPow2 - 1)) == 0 &&
+                 "Queue capacity must be a power of 2");
+    for (u64 i = 0; i < capacityPow2; ++i) {
+      m_Cells[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedMpmcQueue(const BoundedMpmcQueue &) = delete;
+  BoundedMpmcQueue &operator=(const BoundedMpmcQueue &) = delete;
+
+  bool Push(T item) noexcept {
+    u64 position = m_EnqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = m_Cells[position & m_Mask];
+      u64 sequence = cell.Sequence.load(std::memory_order_acquire);
+      i64 diff = static_cast<i64>(sequence) - static_cast<i64>(position);
+      if (diff == 0) {
+        if (m_EnqueuePos.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+          cell.Data = item;
+          cell.Sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // full
+      } else {
+        position = m_EnqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool Pop(T &out) noexcept {
+    u64 position = m_DequeuePos.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell &cell = m_Cells[position & m_Mask];
+      u64 sequence = cell.Sequence.load(std::memory_order_acquire);
+      i64 diff = static_cast<i64>(sequence) - static_cast<i64>(position + 1);
+      if (diff == 0) {
+        if (m_DequeuePos.compare_exchange_weak(position, position + 1,
+                                               std::memory_order_relaxed)) {
+          out = cell.Data;
+          cell.Sequence.store(position + m_Mask + 1,
+                              std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false; // empty
+      } else {
+        position = m_DequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Approximate, for wake-up heuristics and telemetry only.
+  u64 SizeApprox() const noexcept {
+    u64 enqueue = m_EnqueuePos.load(std::memory_order_relaxed);
+    u64 dequeue = m_DequeuePos.load(std::memory_order_relaxed);
+    return enqueue > dequeue ? enqueue - dequeue : 0;
+  }
+
+  bool Empty() const noexcept { return SizeApprox() == 0; }
+
+private:
+  struct Cell {
+    std::atomic<u64> Sequence{0};
+    T Data{};
+  };
+
+  std::unique_ptr<Cell[]> m_Cells;
+  u64 m_Mask{0};
+  alignas(64) std::atomic<u64> m_EnqueuePos{0};
+  alignas(64) std::atomic<u64> m_DequeuePos{0};
+};
+
+} // namespace gecko::runtime
@@ -6,6 +6,8 @@ inline constexpr auto General = MakeCategory("runtime");
 inline constexpr auto Runtime = MakeCategory("runtime::job_system");
 inline constexpr auto TrackingAllocator =
     MakeCategory("runtime::tracking_allocator");
+inline constexpr auto ThreadCachingAllocator =
+    MakeCategory("runtime::thread_caching_allocator");
 inline constexpr auto Logger = MakeCategory("runtime::Logger");
 inline constexpr auto Profiler = MakeCategory("runtime::Profiler");
 inline constexpr auto OperatorNew = MakeCategory("operator_new");
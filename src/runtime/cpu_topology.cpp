@@ -0,0 +1,272 @@
+#include "gecko/runtime/cpu_topology.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <tuple>
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <sched.h>
+#endif
+
+namespace gecko::runtime {
+
+namespace {
+
+struct RawCpu {
+  u32 Id{0};
+  u32 Package{0};
+  u64 CoreKey{0};
+  u64 CacheKey{0};
+  u32 Node{0};
+};
+
+// Replaces every key with its rank among the distinct keys and returns how
+// many distinct keys there were.
+template <typename Key, typename Get, typename Set>
+u32 Densify(std::vector<RawCpu> &raw, std::vector<CpuInfo> &cpus, Get get,
+            Set set) {
+  std::vector<Key> keys;
+  keys.reserve(raw.size());
+  for (const RawCpu &cpu : raw)
+    keys.push_back(get(cpu));
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+  for (size_t i = 0; i < raw.size(); ++i) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), get(raw[i]));
+    set(cpus[i], static_cast<u32>(it - keys.begin()));
+  }
+  return static_cast<u32>(keys.size());
+}
+
+#if defined(__linux__)
+
+constexpr const char *SysCpuPath = "/sys/devices/system/cpu";
+
+bool ReadU32(const char *path, u32 &out) noexcept {
+  FILE *file = std::fopen(path, "r");
+  if (!file)
+    return false;
+  unsigned value = 0;
+  const bool ok = std::fscanf(file, "%u", &value) == 1;
+  std::fclose(file);
+  if (ok)
+    out = value;
+  return ok;
+}
+
+// Rounded-up CPUs allowed by a cgroup v2 cpu.max file ("<quota> <period>"
+// or "max <period>"), 0 when unlimited or unreadable.
+u32 ReadCpuMax(const char *path) noexcept {
+  FILE *file = std::fopen(path, "r");
+  if (!file)
+    return 0;
+  char quota[32] = {};
+  unsigned long long period = 0;
+  const bool ok = std::fscanf(file, "%31s %llu", quota, &period) == 2;
+  std::fclose(file);
+  if (!ok || period == 0 || std::strcmp(quota, "max") == 0)
+    return 0;
+
+  const unsigned long long limit = std::strtoull(quota, nullptr, 10);
+  return static_cast<u32>(std::max(1ull, (limit + period - 1) / period));
+}
+
+u32 ReadNumaNode(u32 cpu) noexcept {
+  char path[128];
+  std::snprintf(path, sizeof(path), "%s/cpu%u", SysCpuPath, cpu);
+  DIR *dir = opendir(path);
+  if (!dir)
+    return 0;
+
+  u32 node = 0;
+  while (dirent *entry = readdir(dir)) {
+    unsigned value = 0;
+    if (std::sscanf(entry->d_name, "node%u", &value) == 1) {
+      node = value;
+      break;
+    }
+  }
+  closedir(dir);
+  return node;
+}
+
+// The highest cache level this CPU has, keyed by the first CPU sharing it.
+bool ReadLastLevelCacheKey(u32 cpu, u64 &out) noexcept {
+  u32 bestLevel = 0;
+  for (u32 index = 0; index < 16; ++index) {
+    char path[128];
+    std::snprintf(path, sizeof(path), "%s/cpu%u/cache/index%u/level",
+                  SysCpuPath, cpu, index);
+    u32 level = 0;
+    if (!ReadU32(path, level))
+      break;
+    if (level < bestLevel)
+      continue;
+
+    std::snprintf(path, sizeof(path),
+                  "%s/cpu%u/cache/index%u/shared_cpu_list", SysCpuPath, cpu,
+                  index);
+    // CPU lists look like "0-3,8,10-11"; the first CPU is a stable key for
+    // the cache instance.
+    u32 firstCpu = 0;
+    if (ReadU32(path, firstCpu)) {
+      bestLevel = level;
+      out = (static_cast<u64>(level) << 32) | firstCpu;
+    }
+  }
+  return bestLevel != 0;
+}
+
+bool ReadRawTopology(std::vector<RawCpu> &raw) {
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return false;
+
+  for (u32 cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (!CPU_ISSET(cpu, &allowed))
+      continue;
+
+    RawCpu info;
+    info.Id = cpu;
+
+    char path[128];
+    std::snprintf(path, sizeof(path), "%s/cpu%u/topology/physical_package_id",
+                  SysCpuPath, cpu);
+    if (!ReadU32(path, info.Package))
+      return false;
+
+    u32 coreId = cpu;
+    std::snprintf(path, sizeof(path), "%s/cpu%u/topology/core_id", SysCpuPath,
+                  cpu);
+    ReadU32(path, coreId);
+    // core_id is only unique within a package
+    info.CoreKey = (static_cast<u64>(info.Package) << 32) | coreId;
+
+    if (!ReadLastLevelCacheKey(cpu, info.CacheKey))
+      info.CacheKey = info.Package;
+
+    info.Node = ReadNumaNode(cpu);
+    raw.push_back(info);
+  }
+  return !raw.empty();
+}
+
+#endif
+
+void FlatTopology(std::vector<RawCpu> &raw) {
+  raw.clear();
+  const u32 count = std::max(1u, std::thread::hardware_concurrency());
+  for (u32 cpu = 0; cpu < count; ++cpu) {
+    RawCpu info;
+    info.Id = cpu;
+    info.CoreKey = cpu;
+    raw.push_back(info);
+  }
+}
+
+} // namespace
+
+u32 DetectCpuQuota() noexcept {
+#if defined(__linux__)
+  try {
+    // Under cgroup v2 the process's own cgroup is the "0::<path>" line.
+    std::string path;
+    FILE *file = std::fopen("/proc/self/cgroup", "r");
+    if (!file)
+      return 0;
+    char line[512];
+    bool found = false;
+    while (!found && std::fgets(line, sizeof(line), file)) {
+      if (std::strncmp(line, "0::", 3) == 0) {
+        path = line + 3;
+        found = true;
+      }
+    }
+    std::fclose(file);
+    if (!found)
+      return 0;
+    while (!path.empty() && (path.back() == '\n' || path.back() == '/'))
+      path.pop_back();
+
+    // A parent's limit applies to every cgroup below it, so take the
+    // tightest one on the way up to the root.
+    u32 quota = 0;
+    for (;;) {
+      const std::string cpuMax = "/sys/fs/cgroup" + path + "/cpu.max";
+      const u32 limit = ReadCpuMax(cpuMax.c_str());
+      if (limit != 0 && (quota == 0 || limit < quota))
+        quota = limit;
+      if (path.empty())
+        break;
+      const size_t slash = path.rfind('/');
+      path.resize(slash == std::string::npos ? 0 : slash);
+    }
+    return quota;
+  } catch (...) {
+    return 0;
+  }
+#else
+  return 0;
+#endif
+}
+
+CpuTopology DetectCpuTopology() noexcept {
+  CpuTopology topology;
+  try {
+    std::vector<RawCpu> raw;
+#if defined(__linux__)
+    if (!ReadRawTopology(raw))
+      FlatTopology(raw);
+#else
+    FlatTopology(raw);
+#endif
+
+    std::vector<CpuInfo> cpus(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i)
+      cpus[i].Id = raw[i].Id;
+
+    topology.CoreCount = Densify<u64>(
+        raw, cpus, [](const RawCpu &cpu) { return cpu.CoreKey; },
+        [](CpuInfo &cpu, u32 value) { cpu.Core = value; });
+    topology.CacheDomainCount = Densify<u64>(
+        raw, cpus, [](const RawCpu &cpu) { return cpu.CacheKey; },
+        [](CpuInfo &cpu, u32 value) { cpu.CacheDomain = value; });
+    topology.NumaNodeCount = Densify<u32>(
+        raw, cpus, [](const RawCpu &cpu) { return cpu.Node; },
+        [](CpuInfo &cpu, u32 value) { cpu.NumaNode = value; });
+    topology.PackageCount = Densify<u32>(
+        raw, cpus, [](const RawCpu &cpu) { return cpu.Package; },
+        [](CpuInfo &cpu, u32 value) { cpu.Package = value; });
+
+    // Hardware threads of a core get SMT indices in CPU id order
+    std::sort(cpus.begin(), cpus.end(),
+              [](const CpuInfo &a, const CpuInfo &b) {
+                return std::tie(a.Core, a.Id) < std::tie(b.Core, b.Id);
+              });
+    for (size_t i = 1; i < cpus.size(); ++i) {
+      if (cpus[i].Core == cpus[i - 1].Core)
+        cpus[i].SmtIndex = cpus[i - 1].SmtIndex + 1;
+    }
+
+    std::sort(cpus.begin(), cpus.end(),
+              [](const CpuInfo &a, const CpuInfo &b) {
+                return std::tie(a.NumaNode, a.CacheDomain, a.Core,
+                                a.SmtIndex) < std::tie(b.NumaNode,
+                                                       b.CacheDomain, b.Core,
+                                                       b.SmtIndex);
+              });
+    topology.Cpus = std::move(cpus);
+  } catch (...) {
+    topology = CpuTopology{};
+  }
+  return topology;
+}
+
+} // namespace gecko::runtime
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+
+#include "gecko/core/category.h"
+#include "gecko/core/types.h"
+#include "gecko/runtime/latency_histogram.h"
+
+namespace gecko::runtime {
+
+// LatencyHistogram that several threads can record into while another one
+// reads it. Recording is three relaxed increments; readers see a slightly
+// torn but monotonic view, which is fine for telemetry.
+struct AtomicLatencyHistogram {
+  // Shared = false is for blocks only one thread ever records into: the
+  // increments then skip the locked read-modify-write.
+  template <bool Shared> static void Add(std::atomic<u64> &value, u64 amount) {
+    if constexpr (Shared)
+      value.fetch_add(amount, std::memory_order_relaxed);
+    else
+      value.store(value.load(std::memory_order_relaxed) + amount,
+                  std::memory_order_relaxed);
+  }
+
+  template <bool Shared> void Record(u64 ns) noexcept {
+    Add<Shared>(Buckets[LatencyHistogram::BucketIndex(ns)], 1);
+    Add<Shared>(SumNs, ns);
+    u64 max = MaxNs.load(std::memory_order_relaxed);
+    while (ns > max && !MaxNs.compare_exchange_weak(max, ns,
+                                                    std::memory_order_relaxed))
+      ;
+  }
+
+  void AddTo(LatencyHistogram &out) const noexcept {
+    for (u32 i = 0; i < LatencyHistogram::BucketCount; ++i) {
+      const u64 count = Buckets[i].load(std::memory_order_relaxed);
+      out.Buckets[i] += count;
+      out.Count += count;
+    }
+    out.SumNs += SumNs.load(std::memory_order_relaxed);
+    const u64 max = MaxNs.load(std::memory_order_relaxed);
+    if (max > out.MaxNs)
+      out.MaxNs = max;
+  }
+
+  std::atomic<u64> Buckets[LatencyHistogram::BucketCount]{};
+  std::atomic<u64> SumNs{0};
+  std::atomic<u64> MaxNs{0};
+};
+
+// Queue wait (submit to start) and run time of a set of jobs.
+struct AtomicJobLatency {
+  AtomicLatencyHistogram Wait;
+  AtomicLatencyHistogram Run;
+};
+
+// Counters for the jobs one worker executed. Each worker owns a block, so
+// the increments stay on cache lines nobody else writes; jobs run by
+// non-worker threads (Wait, ProcessJobs) share one extra block.
+struct alignas(64) WorkerTelemetry {
+  static constexpr u32 PriorityCount = 3;
+  // Distinct categories tracked per block; later ones only count towards
+  // their priority.
+  static constexpr u32 CategorySlotCount = 8;
+
+  // Marks a slot whose owner is still filling in the name.
+  static constexpr u32 ClaimingSlot = ~0u;
+
+  struct CategorySlot {
+    // 0 while free; claimed once and never released.
+    std::atomic<u32> Id{0};
+    const char *Name{nullptr};
+    AtomicJobLatency Latency;
+  };
+
+  // Uncategorized jobs (id 0) are only tracked per priority. Two threads
+  // racing for the same new category may each claim a slot; readers merge
+  // slots by id.
+  AtomicJobLatency *FindCategory(Category category) noexcept {
+    if (category.Id == 0 || category.Id == ClaimingSlot)
+      return nullptr;
+
+    for (CategorySlot &slot : Categories) {
+      u32 id = slot.Id.load(std::memory_order_acquire);
+      if (id == 0 && slot.Id.compare_exchange_strong(
+                         id, ClaimingSlot, std::memory_order_acquire)) {
+        slot.Name = category.Name;
+        slot.Id.store(category.Id, std::memory_order_release);
+        return &slot.Latency;
+      }
+      if (id == category.Id)
+        return &slot.Latency;
+    }
+    return nullptr;
+  }
+
+  template <bool Shared>
+  void RecordJob(u32 priority, Category category, u64 waitNs,
+                 u64 runNs) noexcept {
+    AtomicLatencyHistogram::Add<Shared>(JobsExecuted, 1);
+    AtomicLatencyHistogram::Add<Shared>(BusyNs, runNs);
+    ByPriority[priority].Wait.Record<Shared>(waitNs);
+    ByPriority[priority].Run.Record<Shared>(runNs);
+    if (AtomicJobLatency *latency = FindCategory(category)) {
+      latency->Wait.Record<Shared>(waitNs);
+      latency->Run.Record<Shared>(runNs);
+    }
+  }
+
+  std::atomic<u64> JobsExecuted{0};
+  std::atomic<u64> JobsStolen{0};
+  std::atomic<u64> BusyNs{0};
+
+  AtomicJobLatency ByPriority[PriorityCount];
+  CategorySlot Categories[CategorySlotCount];
+};
+
+} // namespace gecko::runtime
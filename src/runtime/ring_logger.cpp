@@ -1,11 +1,13 @@
 #include "gecko/runtime/ring_logger.h"
 
+#include <algorithm>
 #include <atomic>
 #include <cstdarg>
 #include <cstdio>
 #include <cstring>
 #include <mutex>
 #include <thread>
+#include <utility>
 
 #include "categories.h"
 #include "gecko/core/assert.h"
@@ -17,6 +19,31 @@
 
 namespace gecko::runtime {
 
+namespace {
+// How long after the first emit the consumer job drains the ring, so a burst
+// of messages reaches the sinks in one pass.
+constexpr u64 ConsumerDelayNs = time::MillisecondsToNs(1);
+
+// Owns one count of a ring's active consumers for as long as the consumer
+// job's function lives. The job system destroys the function once the job
+// has run, and also when it drops the job unrun (still in the timer wheel at
+// Shutdown, say), so WaitForConsumers returns either way.
+class ConsumerClaim {
+public:
+  explicit ConsumerClaim(std::atomic<u32> &count) noexcept : m_Count(&count) {}
+  ConsumerClaim(ConsumerClaim &&other) noexcept
+      : m_Count(std::exchange(other.m_Count, nullptr)) {}
+  ConsumerClaim &operator=(ConsumerClaim &&) = delete;
+  ~ConsumerClaim() {
+    if (m_Count)
+      m_Count->fetch_sub(1, std::memory_order_release);
+  }
+
+private:
+  std::atomic<u32> *m_Count;
+};
+} // namespace
+
 u64 RingLogger::NowNs() noexcept { return MonotonicTimeNs(); }
 
 u32 RingLogger::ThreadId() noexcept { return HashThreadId(); }
@@ -52,6 +79,11 @@ void RingLogger::LogV(LogLevel level, Category category, const char *fmt,
       static_cast<int>(m_Level.load(std::memory_order_relaxed)))
     return;
 
+  // After Shutdown nothing will drain the ring again except the destructor,
+  // by which point the sinks may already be gone.
+  if (!m_Run.load(std::memory_order_relaxed))
+    return;
+
   char buffer[512];
   va_list ap;
   va_copy(ap, apIn);
@@ -69,7 +101,10 @@ void RingLogger::LogV(LogLevel level, Category category, const char *fmt,
     // The ring is full for this slot. We must not "skip" positions, otherwise
     // the single consumer can get stuck waiting for an unpublished entry.
     // Try to drain a bit on the current thread to ensure forward progress.
-    ProcessLogEntries();
+    if (!m_InlineDrain.test_and_set(std::memory_order_acquire)) {
+      ProcessLogEntries();
+      m_InlineDrain.clear(std::memory_order_release);
+    }
     std::this_thread::yield();
     sequence = entry.Sequence.load(std::memory_order_acquire);
   }
@@ -86,8 +121,82 @@ void RingLogger::LogV(LogLevel level, Category category, const char *fmt,
 
   entry.Sequence.store(position + 1, std::memory_order_release);
 
-  // Try to schedule processing, but don't wait if job system is busy
-  TryScheduleConsumerJob();
+  // Pairs with the fence in RunConsumer: either the consumer still sees this
+  // entry, or we see that its drain is over and schedule the next one.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  ScheduleConsumer();
+}
+
+void RingLogger::ScheduleConsumer() noexcept {
+  if (m_DrainPending.load(std::memory_order_relaxed) ||
+      m_DrainPending.exchange(true, std::memory_order_seq_cst))
+    return;
+
+  // Shutdown may have started since LogV checked m_Run. Either it sees this
+  // consumer and waits for it, or we see m_Run cleared and back out.
+  m_ActiveConsumers.fetch_add(1, std::memory_order_seq_cst);
+  if (!m_Run.load(std::memory_order_seq_cst)) {
+    m_DrainPending.store(false, std::memory_order_release);
+    m_ActiveConsumers.fetch_sub(1, std::memory_order_release);
+    return;
+  }
+
+  // Sinks may block on file I/O, so the consumer runs on the Io group, never
+  // on the compute workers.
+  JobDesc desc;
+  desc.Function = [this, claim = ConsumerClaim(m_ActiveConsumers)]() {
+    RunConsumer();
+  };
+  desc.Priority = JobPriority::Normal;
+  desc.Cat = m_LoggerCategory;
+  desc.Group = WorkerGroup::Io;
+  desc.Flags = JobFlags::Blocking;
+
+  const u64 runs = m_ConsumerRuns.load(std::memory_order_relaxed);
+  JobHandle consumer =
+      SubmitJobAt(std::move(desc), NowNs() + ConsumerDelayNs);
+  if (consumer.IsValid()) {
+    m_Consumer.store(consumer, std::memory_order_release);
+    return;
+  }
+
+  // A job system without a timer has already run it in place; one that is
+  // out of job slots dropped it, so drain here instead. Either way the claim
+  // went with the function.
+  if (m_ConsumerRuns.load(std::memory_order_relaxed) == runs)
+    RunConsumer();
+}
+
+void RingLogger::RunConsumer() noexcept {
+  m_ConsumerRuns.fetch_add(1, std::memory_order_relaxed);
+  do {
+    DrainPending();
+    m_DrainPending.store(false, std::memory_order_relaxed);
+    // Pairs with the fence in LogV: an emit that still saw the flag set left
+    // its entry to this consumer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  } while (m_Run.load(std::memory_order_relaxed) && HasPendingEntries() &&
+           !m_DrainPending.exchange(true, std::memory_order_acquire));
+}
+
+void RingLogger::DrainPending() noexcept {
+  // Whoever holds the flag is already reading the ring
+  if (m_InlineDrain.test_and_set(std::memory_order_acquire))
+    return;
+  while (m_Run.load(std::memory_order_relaxed) && HasPendingEntries())
+    ProcessLogEntries();
+  m_InlineDrain.clear(std::memory_order_release);
+}
+
+void RingLogger::WaitForConsumers() noexcept {
+  // A consumer submitted a moment ago may not have published its handle yet,
+  // in which case this waits on the previous one and goes around again. The
+  // count drops when the job system lets go of the consumer's function, run
+  // or not, so a consumer dropped at job system Shutdown ends the wait too.
+  while (m_ActiveConsumers.load(std::memory_order_seq_cst) != 0) {
+    WaitForJob(m_Consumer.load(std::memory_order_acquire));
+    std::this_thread::yield();
+  }
 }
 
 void RingLogger::ProcessLogEntries() noexcept {
@@ -140,48 +249,6 @@ void RingLogger::ProcessLogEntries() noexcept {
     for (auto *sink : m_Sinks)
       sink->Write(dropMessage);
   }
-
-  // Always check if there are more entries to process
-  if (HasPendingEntries()) {
-    ScheduleNextConsumerJob();
-  }
-}
-
-void RingLogger::TryScheduleConsumerJob() noexcept {
-  if (!m_Run.load(std::memory_order_relaxed))
-    return;
-
-  // Only schedule if there's no active consumer job
-  if (m_ConsumerJob.IsValid() && !IsJobComplete(m_ConsumerJob))
-    return;
-
-  auto *jobSystem = GetJobSystem();
-  if (!jobSystem) {
-    // No job system available, process immediately on current thread
-    ProcessLogEntries();
-    return;
-  }
-
-  // Use normal priority for logger jobs and limit how often we schedule
-  static std::atomic<u64> lastScheduleTime{0};
-  u64 now = NowNs();
-  u64 lastTime = lastScheduleTime.load(std::memory_order_relaxed);
-
-  // Don't schedule too frequently (at most every 100µs) to avoid job spam
-  if (now - lastTime < 100000) // 100 microseconds
-  {
-    return;
-  }
-
-  if (lastScheduleTime.compare_exchange_weak(lastTime, now,
-                                             std::memory_order_relaxed)) {
-    m_ConsumerJob = jobSystem->Submit([this]() { ProcessLogEntries(); },
-                                      JobPriority::Normal, m_LoggerCategory);
-  }
-}
-
-void RingLogger::ScheduleNextConsumerJob() noexcept {
-  TryScheduleConsumerJob();
 }
 
 bool RingLogger::HasPendingEntries() const noexcept {
@@ -192,6 +259,9 @@ bool RingLogger::HasPendingEntries() const noexcept {
 }
 
 void RingLogger::Flush() noexcept {
+  while (m_InlineDrain.test_and_set(std::memory_order_acquire))
+    std::this_thread::yield();
+
   while (true) {
     bool processedAny = false;
 
@@ -217,26 +287,25 @@ void RingLogger::Flush() noexcept {
     if (!processedAny)
       break;
   }
+
+  m_InlineDrain.clear(std::memory_order_release);
 }
 
 bool RingLogger::Init() noexcept {
-  m_Run.store(true, std::memory_order_relaxed);
-
   // JobSystem is now available during Logger initialization (Allocator ->
-  // JobSystem -> Profiler -> Logger order) Start the initial consumer job
-  // immediately
-  ScheduleNextConsumerJob();
+  // JobSystem -> Profiler -> Logger order). Consumer jobs are only scheduled
+  // once something is logged, so an idle logger never wakes a worker.
+  m_Run.store(true, std::memory_order_relaxed);
 
   return true;
 }
 
 void RingLogger::Shutdown() noexcept {
-  m_Run.store(false, std::memory_order_relaxed);
+  m_Run.store(false, std::memory_order_seq_cst);
 
-  // Wait for any running consumer job to complete
-  if (m_ConsumerJob.IsValid()) {
-    WaitForJob(m_ConsumerJob);
-  }
+  // A queued consumer still runs, but finds m_Run cleared and leaves the rest
+  // to Flush.
+  WaitForConsumers();
 
   // Process any remaining entries
   Flush();
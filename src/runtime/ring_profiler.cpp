@@ -6,6 +6,8 @@
 #include "gecko/core/thread.h"
 #include "gecko/core/time.h"
 #include <algorithm>
+#include <thread>
+#include <utility>
 #include <vector>
 
 namespace gecko {
@@ -15,6 +17,44 @@ u32 ThisThreadId() noexcept { return HashThreadId(); }
 
 namespace gecko::runtime {
 
+namespace {
+// How long after the first emit the consumer job drains the ring, so a burst
+// of events reaches the sinks in one pass.
+constexpr u64 ConsumerDelayNs = time::MillisecondsToNs(1);
+
+// The job system profiles the consumer job too: its Job::Execute zone ends
+// and the worker may park right after the drain. Those events wait for the
+// next drain instead of scheduling one, or an idle profiler would keep
+// feeding itself.
+constexpr u32 ConsumerTrailEvents = 2;
+
+struct ConsumerTrail {
+  const void *Profiler{nullptr};
+  u32 Events{0};
+};
+
+thread_local ConsumerTrail t_ConsumerTrail;
+
+// Owns one count of a ring's active consumers for as long as the consumer
+// job's function lives. The job system destroys the function once the job
+// has run, and also when it drops the job unrun (still in the timer wheel at
+// Shutdown, say), so WaitForConsumers returns either way.
+class ConsumerClaim {
+public:
+  explicit ConsumerClaim(std::atomic<u32> &count) noexcept : m_Count(&count) {}
+  ConsumerClaim(ConsumerClaim &&other) noexcept
+      : m_Count(std::exchange(other.m_Count, nullptr)) {}
+  ConsumerClaim &operator=(ConsumerClaim &&) = delete;
+  ~ConsumerClaim() {
+    if (m_Count)
+      m_Count->fetch_sub(1, std::memory_order_release);
+  }
+
+private:
+  std::atomic<u32> *m_Count;
+};
+} // namespace
+
 u64 RingProfiler::MonotonicNowNs() noexcept { return MonotonicTimeNs(); }
 
 RingProfiler::RingProfiler(size_t capacityPow2)
@@ -37,10 +77,8 @@ RingProfiler::~RingProfiler() {
   // Stop accepting new events
   m_Run.store(false, std::memory_order_relaxed);
 
-  // Wait for any active consumer job to complete
-  if (m_ConsumerJob.IsValid()) {
-    WaitForJob(m_ConsumerJob);
-  }
+  m_UseConsumer.store(false, std::memory_order_seq_cst);
+  WaitForConsumers();
 
   // Process any remaining events to ensure sinks get final data
   ProcessProfEvents();
@@ -58,8 +96,17 @@ void RingProfiler::Emit(const ProfEvent &event) noexcept {
     slot.ProfileEvent = event; // copy event
     slot.Sequence.store(pos + 1, std::memory_order_release);
 
-    // Try to schedule async processing
-    TryScheduleConsumerJob();
+    if (t_ConsumerTrail.Profiler == this && t_ConsumerTrail.Events > 0) {
+      --t_ConsumerTrail.Events;
+    } else if (m_UseConsumer.load(std::memory_order_relaxed)) {
+      // Pairs with the fence in RunConsumer: either the consumer still sees
+      // this event, or we see that its drain is over and schedule the next.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      ScheduleConsumer();
+    } else if (!m_InlineDrain.test_and_set(std::memory_order_acquire)) {
+      ProcessProfEvents();
+      m_InlineDrain.clear(std::memory_order_release);
+    }
   } else {
     // overflow — drop event (cheap fallback)
     // Optionally: back off or count drops.
@@ -80,9 +127,94 @@ bool RingProfiler::TryPop(ProfEvent &event) noexcept {
   return false;
 }
 
-bool RingProfiler::Init() noexcept { return true; }
+void RingProfiler::ScheduleConsumer() noexcept {
+  if (m_DrainPending.load(std::memory_order_relaxed) ||
+      m_DrainPending.exchange(true, std::memory_order_seq_cst))
+    return;
+
+  // Shutdown may have started since Emit checked m_UseConsumer. Either it
+  // sees this consumer and waits for it, or we see the flag cleared and drain
+  // in place like Emit does from then on.
+  m_ActiveConsumers.fetch_add(1, std::memory_order_seq_cst);
+  if (!m_UseConsumer.load(std::memory_order_seq_cst)) {
+    m_DrainPending.store(false, std::memory_order_release);
+    m_ActiveConsumers.fetch_sub(1, std::memory_order_release);
+    DrainPending();
+    return;
+  }
+
+  // Sinks may block on file I/O, so the consumer runs on the Io group, never
+  // on the compute workers.
+  JobDesc desc;
+  desc.Function = [this, claim = ConsumerClaim(m_ActiveConsumers)]() {
+    RunConsumer();
+    t_ConsumerTrail = {this, ConsumerTrailEvents};
+  };
+  desc.Priority = JobPriority::Low;
+  desc.Cat = m_ProfilerCategory;
+  desc.Group = WorkerGroup::Io;
+  desc.Flags = JobFlags::Blocking;
+
+  const u64 runs = m_ConsumerRuns.load(std::memory_order_relaxed);
+  JobHandle consumer =
+      SubmitJobAt(std::move(desc), MonotonicNowNs() + ConsumerDelayNs);
+  if (consumer.IsValid()) {
+    m_Consumer.store(consumer, std::memory_order_release);
+    return;
+  }
+
+  // A job system without a timer has already run it in place; one that is
+  // out of job slots dropped it, so drain here instead. Either way the claim
+  // went with the function.
+  if (m_ConsumerRuns.load(std::memory_order_relaxed) == runs)
+    RunConsumer();
+}
+
+void RingProfiler::RunConsumer() noexcept {
+  m_ConsumerRuns.fetch_add(1, std::memory_order_relaxed);
+  do {
+    DrainPending();
+    m_DrainPending.store(false, std::memory_order_relaxed);
+    // Pairs with the fence in Emit: an emit that still saw the flag set left
+    // its event to this consumer.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+  } while (m_Run.load(std::memory_order_relaxed) && HasPendingEvents() &&
+           !m_DrainPending.exchange(true, std::memory_order_acquire));
+}
+
+void RingProfiler::DrainPending() noexcept {
+  // Whoever holds the flag is already reading the ring
+  if (m_InlineDrain.test_and_set(std::memory_order_acquire))
+    return;
+  while (m_Run.load(std::memory_order_relaxed) && HasPendingEvents())
+    ProcessProfEvents();
+  m_InlineDrain.clear(std::memory_order_release);
+}
+
+void RingProfiler::WaitForConsumers() noexcept {
+  // A consumer submitted a moment ago may not have published its handle yet,
+  // in which case this waits on the previous one and goes around again. The
+  // count drops when the job system lets go of the consumer's function, run
+  // or not, so a consumer dropped at job system Shutdown ends the wait too.
+  while (m_ActiveConsumers.load(std::memory_order_seq_cst) != 0) {
+    WaitForJob(m_Consumer.load(std::memory_order_acquire));
+    std::this_thread::yield();
+  }
+}
+
+bool RingProfiler::Init() noexcept {
+  // Consumer jobs are only scheduled once something is emitted, so an idle
+  // profiler never wakes a worker.
+  m_UseConsumer.store(true, std::memory_order_relaxed);
+  return true;
+}
 
-void RingProfiler::Shutdown() noexcept {}
+void RingProfiler::Shutdown() noexcept {
+  // The job system shuts down right after us, so Emit drains the ring itself
+  // from here on. Wait out the consumer so the two never overlap.
+  m_UseConsumer.store(false, std::memory_order_seq_cst);
+  WaitForConsumers();
+}
 
 void RingProfiler::AddSink(IProfilerSink *sink) noexcept {
   if (sink) {
@@ -122,54 +254,15 @@ void RingProfiler::ProcessProfEvents() noexcept {
       }
     }
   }
-
-  // Continue processing if more events are pending
-  if (HasPendingEvents()) {
-    ScheduleNextConsumerJob();
-  }
-}
-
-void RingProfiler::TryScheduleConsumerJob() noexcept {
-  if (!m_Run.load(std::memory_order_relaxed))
-    return;
-
-  // Only schedule if there's no active consumer job
-  if (m_ConsumerJob.IsValid() && !IsJobComplete(m_ConsumerJob))
-    return;
-
-  auto *jobSystem = GetJobSystem();
-  if (!jobSystem) {
-    // No job system available, process immediately on current thread
-    ProcessProfEvents();
-    return;
-  }
-
-  // Use low priority for profiler jobs and limit scheduling frequency
-  static std::atomic<u64> lastScheduleTime{0};
-  u64 now = NowNs();
-  u64 lastTime = lastScheduleTime.load(std::memory_order_relaxed);
-
-  // Don't schedule too frequently (at most every 100µs) to avoid job spam
-  if (now - lastTime < 100000) // 100 microseconds
-  {
-    return;
-  }
-
-  if (lastScheduleTime.compare_exchange_weak(lastTime, now,
-                                             std::memory_order_relaxed)) {
-    m_ConsumerJob = jobSystem->Submit([this]() { ProcessProfEvents(); },
-                                      JobPriority::Low, m_ProfilerCategory);
-  }
-}
-
-void RingProfiler::ScheduleNextConsumerJob() noexcept {
-  TryScheduleConsumerJob();
 }
 
 bool RingProfiler::HasPendingEvents() const noexcept {
-  u64 head = m_Head.load(std::memory_order_relaxed);
-  u64 tail = m_Tail.load(std::memory_order_relaxed);
-  return head != tail;
+  // Looks at the tail slot rather than comparing head and tail: a dropped or
+  // half-written event must not keep a consumer spinning.
+  u64 pos = m_Tail.load(std::memory_order_relaxed);
+  const Slot &slot = m_Ring[pos & m_Mask];
+  u64 sequence = slot.Sequence.load(std::memory_order_acquire);
+  return (i64)sequence - (i64)(pos + 1) == 0;
 }
 
 } // namespace gecko::runtime
@@ -0,0 +1,483 @@
+#include "gecko/runtime/thread_caching_allocator.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include "categories.h"
+#include "gecko/core/assert.h"
+
+namespace gecko::runtime {
+
+namespace {
+
+constexpr u32 PageShift = 16;
+constexpr u32 LeafBits = 16;
+constexpr u64 LeafSize = u64{1} << LeafBits;
+constexpr u32 TopBits = 16;
+constexpr u64 TopSize = u64{1} << TopBits;
+constexpr u32 AddressBits = PageShift + LeafBits + TopBits;
+
+// Bytes a thread moves to or from the central pool at a time.
+constexpr u64 BatchBytes = 32 * 1024;
+constexpr u32 MinBatch = 4;
+constexpr u32 MaxBatch = 64;
+
+static_assert(ThreadCachingAllocator::SpanSize == u64{1} << PageShift);
+static_assert(ThreadCachingAllocator::ClassSize(
+                  ThreadCachingAllocator::ClassCount - 1) ==
+              ThreadCachingAllocator::MaxSmallSize);
+
+struct Registration {
+  u64 Id{0};
+  ThreadCachingAllocator *Allocator{nullptr};
+};
+
+// Live allocators by id, so an exiting thread never hands its caches to one
+// that is already gone.
+std::mutex s_RegistryMutex;
+Registration s_Registry[ThreadCachingAllocator::MaxInstances];
+u64 s_NextId = 1;
+
+struct ThreadCacheSlot {
+  u64 Id{0};
+  void *Cache{nullptr};
+};
+
+thread_local ThreadCacheSlot
+    t_CacheSlots[ThreadCachingAllocator::CacheSlotCount];
+thread_local bool t_CachesReleased = false;
+
+bool IsRegisteredLocked(u64 id) noexcept {
+  for (const Registration &entry : s_Registry) {
+    if (entry.Id == id)
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+// Hands a thread's caches back when it exits. Only constructed once the
+// thread takes its first cache, so threads that never allocate pay nothing.
+struct ThreadCacheReleaser {
+  bool Armed{false};
+
+  ~ThreadCacheReleaser() {
+    t_CachesReleased = true;
+    std::lock_guard<std::mutex> lock(s_RegistryMutex);
+    for (ThreadCacheSlot &slot : t_CacheSlots) {
+      if (slot.Id == 0)
+        continue;
+      for (const Registration &entry : s_Registry) {
+        if (entry.Id == slot.Id) {
+          entry.Allocator->ReleaseCache(
+              static_cast<ThreadCachingAllocator::ThreadCache *>(slot.Cache));
+          break;
+        }
+      }
+      slot = {};
+    }
+  }
+};
+
+namespace {
+thread_local ThreadCacheReleaser t_Releaser;
+} // namespace
+
+ThreadCachingAllocator::ThreadCachingAllocator(IAllocator *upstream) noexcept
+    : m_Upstream(upstream) {
+  GECKO_ASSERT(upstream && "Upstream allocator is required");
+
+  std::lock_guard<std::mutex> lock(s_RegistryMutex);
+  for (Registration &entry : s_Registry) {
+    if (entry.Id == 0) {
+      m_Id = s_NextId++;
+      entry = {m_Id, this};
+      break;
+    }
+  }
+}
+
+ThreadCachingAllocator::~ThreadCachingAllocator() {
+  if (m_Id != 0) {
+    std::lock_guard<std::mutex> lock(s_RegistryMutex);
+    for (Registration &entry : s_Registry) {
+      if (entry.Id == m_Id)
+        entry = {};
+    }
+  }
+
+  // Slots still naming m_Id on other threads are dropped lazily; the id is
+  // never reused.
+  for (ThreadCache *cache = m_OwnedCaches; cache;) {
+    ThreadCache *next = cache->NextOwned;
+    cache->~ThreadCache();
+    m_Upstream->Free(cache, sizeof(ThreadCache), alignof(ThreadCache),
+                     categories::ThreadCachingAllocator);
+    cache = next;
+  }
+
+  for (ChunkNode *chunk = m_Chunks; chunk;) {
+    ChunkNode *next = chunk->Next;
+    m_Upstream->Free(chunk->Base, ChunkSize, SpanSize,
+                     categories::ThreadCachingAllocator);
+    m_Upstream->Free(chunk, sizeof(ChunkNode), alignof(ChunkNode),
+                     categories::ThreadCachingAllocator);
+    chunk = next;
+  }
+
+  if (u8 **map = m_PageMap.load(std::memory_order_acquire)) {
+    for (u64 i = 0; i < TopSize; ++i) {
+      if (map[i])
+        m_Upstream->Free(map[i], LeafSize, 64,
+                         categories::ThreadCachingAllocator);
+    }
+    m_Upstream->Free(map, TopSize * sizeof(u8 *), alignof(u8 *),
+                     categories::ThreadCachingAllocator);
+  }
+}
+
+u32 ThreadCachingAllocator::SizeClassFor(u64 size, u32 alignment) noexcept {
+  if (size > MaxSmallSize)
+    return NoClass;
+
+  u32 sizeClass;
+  if (size <= 128) {
+    sizeClass = static_cast<u32>((std::max<u64>(size, 1) + 15) / 16) - 1;
+  } else {
+    u32 log = static_cast<u32>(std::bit_width(size - 1));
+    u32 index = static_cast<u32>((size - 1) >> (log - 3)) - 4;
+    sizeClass = 8 + (log - 8) * 4 + index;
+  }
+
+  // Blocks sit at multiples of their class size from a span-aligned base, so
+  // over-aligned requests move up to a class the alignment divides.
+  if (alignment > 16) {
+    while (sizeClass < ClassCount && ClassSize(sizeClass) % alignment != 0)
+      ++sizeClass;
+    if (sizeClass == ClassCount)
+      return NoClass;
+  }
+  return sizeClass;
+}
+
+u32 ThreadCachingAllocator::BatchSize(u32 sizeClass) noexcept {
+  static constexpr auto batches = [] {
+    std::array<u32, ClassCount> result{};
+    for (u32 c = 0; c < ClassCount; ++c)
+      result[c] = static_cast<u32>(
+          std::clamp<u64>(BatchBytes / ClassSize(c), MinBatch, MaxBatch));
+    return result;
+  }();
+  return batches[sizeClass];
+}
+
+u32 ThreadCachingAllocator::SizeClassOf(const void *ptr) const noexcept {
+  u64 address = reinterpret_cast<u64>(ptr);
+  if (address >> AddressBits)
+    return NoClass;
+
+  u8 **map = m_PageMap.load(std::memory_order_acquire);
+  if (!map)
+    return NoClass;
+
+  u8 *leaf = std::atomic_ref<u8 *>(map[address >> (PageShift + LeafBits)])
+                 .load(std::memory_order_acquire);
+  if (!leaf)
+    return NoClass;
+
+  u8 entry = std::atomic_ref<u8>(leaf[(address >> PageShift) & (LeafSize - 1)])
+                 .load(std::memory_order_acquire);
+  return entry ? entry - 1u : NoClass;
+}
+
+void *ThreadCachingAllocator::Alloc(u64 size, u32 alignment,
+                                    Category category) noexcept {
+  GECKO_ASSERT(size > 0 && "Cannot allocate zero bytes");
+  GECKO_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0 &&
+               "Alignment must be power of 2");
+
+  u32 sizeClass = SizeClassFor(size, alignment);
+  if (sizeClass == NoClass)
+    return m_Upstream->Alloc(size, alignment, category);
+
+  // When no span can be carved or mapped the request goes upstream. Free
+  // finds no size class for such a block and passes it back.
+  ThreadCache *cache = LocalCache();
+  if (!cache) {
+    FreeBlock *block = nullptr;
+    TakeFromCentral(sizeClass, 1, block);
+    return block ? block : m_Upstream->Alloc(size, alignment, category);
+  }
+
+  FreeList &list = cache->Lists[sizeClass];
+  if (!list.Head) {
+    list.Count = TakeFromCentral(sizeClass, BatchSize(sizeClass), list.Head);
+    if (!list.Head)
+      return m_Upstream->Alloc(size, alignment, category);
+  }
+
+  FreeBlock *block = list.Head;
+  list.Head = block->Next;
+  --list.Count;
+  return block;
+}
+
+void ThreadCachingAllocator::Free(void *ptr, u64 size, u32 alignment,
+                                  Category category) noexcept {
+  if (!ptr)
+    return;
+
+  u32 sizeClass = SizeClassOf(ptr);
+  if (sizeClass == NoClass) {
+    m_Upstream->Free(ptr, size, alignment, category);
+    return;
+  }
+
+  FreeBlock *block = static_cast<FreeBlock *>(ptr);
+  ThreadCache *cache = LocalCache();
+  if (!cache) {
+    block->Next = nullptr;
+    ReturnToCentral(sizeClass, block, block, 1);
+    return;
+  }
+
+  FreeList &list = cache->Lists[sizeClass];
+  block->Next = list.Head;
+  list.Head = block;
+  u32 batch = BatchSize(sizeClass);
+  if (++list.Count > 2 * batch)
+    Drain(sizeClass, list, batch);
+}
+
+ThreadCachingAllocator::ThreadCache *
+ThreadCachingAllocator::LocalCache() noexcept {
+  if (m_Id == 0)
+    return nullptr;
+  for (const ThreadCacheSlot &slot : t_CacheSlots) {
+    if (slot.Id == m_Id)
+      return static_cast<ThreadCache *>(slot.Cache);
+  }
+  return AcquireCache();
+}
+
+ThreadCachingAllocator::ThreadCache *
+ThreadCachingAllocator::AcquireCache() noexcept {
+  if (t_CachesReleased)
+    return nullptr;
+
+  ThreadCacheSlot *free = nullptr;
+  for (ThreadCacheSlot &slot : t_CacheSlots) {
+    if (slot.Id == 0) {
+      free = &slot;
+      break;
+    }
+  }
+  if (!free) {
+    // Slots of allocators destroyed since are fair game; their caches went
+    // with them.
+    std::lock_guard<std::mutex> lock(s_RegistryMutex);
+    for (ThreadCacheSlot &slot : t_CacheSlots) {
+      if (!IsRegisteredLocked(slot.Id)) {
+        slot = {};
+        free = &slot;
+      }
+    }
+    if (!free)
+      return nullptr;
+  }
+
+  ThreadCache *cache = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_CacheMutex);
+    if (m_ParkedCaches) {
+      cache = m_ParkedCaches;
+      m_ParkedCaches = cache->NextParked;
+      cache->NextParked = nullptr;
+    } else if (void *memory = m_Upstream->Alloc(
+                   sizeof(ThreadCache), alignof(ThreadCache),
+                   categories::ThreadCachingAllocator)) {
+      cache = new (memory) ThreadCache{};
+      cache->NextOwned = m_OwnedCaches;
+      m_OwnedCaches = cache;
+    }
+  }
+  if (!cache)
+    return nullptr;
+
+  t_Releaser.Armed = true;
+  *free = {m_Id, cache};
+  return cache;
+}
+
+void ThreadCachingAllocator::ReleaseCache(ThreadCache *cache) noexcept {
+  for (u32 sizeClass = 0; sizeClass < ClassCount; ++sizeClass) {
+    FreeList &list = cache->Lists[sizeClass];
+    if (list.Count > 0)
+      Drain(sizeClass, list, list.Count);
+  }
+
+  std::lock_guard<std::mutex> lock(m_CacheMutex);
+  cache->NextParked = m_ParkedCaches;
+  m_ParkedCaches = cache;
+}
+
+void ThreadCachingAllocator::FlushThreadCache() noexcept {
+  if (m_Id == 0)
+    return;
+  for (ThreadCacheSlot &slot : t_CacheSlots) {
+    if (slot.Id == m_Id) {
+      ReleaseCache(static_cast<ThreadCache *>(slot.Cache));
+      slot = {};
+      return;
+    }
+  }
+}
+
+u32 ThreadCachingAllocator::TakeFromCentral(u32 sizeClass, u32 count,
+                                            FreeBlock *&head) noexcept {
+  CentralList &central = m_Central[sizeClass];
+  std::lock_guard<std::mutex> lock(central.Mutex);
+
+  if (central.Count < count) {
+    FreeBlock *spanHead = nullptr;
+    FreeBlock *spanTail = nullptr;
+    if (u32 carved = CarveSpan(sizeClass, spanHead, spanTail)) {
+      spanTail->Next = central.Head;
+      central.Head = spanHead;
+      central.Count += carved;
+    }
+  }
+
+  u32 taken = std::min(count, central.Count);
+  if (taken == 0) {
+    head = nullptr;
+    return 0;
+  }
+
+  head = central.Head;
+  FreeBlock *tail = head;
+  for (u32 i = 1; i < taken; ++i)
+    tail = tail->Next;
+  central.Head = tail->Next;
+  central.Count -= taken;
+  tail->Next = nullptr;
+  return taken;
+}
+
+void ThreadCachingAllocator::ReturnToCentral(u32 sizeClass, FreeBlock *head,
+                                             FreeBlock *tail,
+                                             u32 count) noexcept {
+  CentralList &central = m_Central[sizeClass];
+  std::lock_guard<std::mutex> lock(central.Mutex);
+  tail->Next = central.Head;
+  central.Head = head;
+  central.Count += count;
+}
+
+void ThreadCachingAllocator::Drain(u32 sizeClass, FreeList &list,
+                                   u32 count) noexcept {
+  FreeBlock *head = list.Head;
+  FreeBlock *tail = head;
+  for (u32 i = 1; i < count; ++i)
+    tail = tail->Next;
+  list.Head = tail->Next;
+  list.Count -= count;
+  ReturnToCentral(sizeClass, head, tail, count);
+}
+
+u32 ThreadCachingAllocator::CarveSpan(u32 sizeClass, FreeBlock *&head,
+                                      FreeBlock *&tail) noexcept {
+  u8 *span = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_SpanMutex);
+    span = static_cast<u8 *>(NextSpanLocked());
+    if (!span || !MapSpanLocked(span, sizeClass))
+      return 0;
+  }
+
+  u64 classSize = ClassSize(sizeClass);
+  u32 count = static_cast<u32>(SpanSize / classSize);
+  head = reinterpret_cast<FreeBlock *>(span);
+  FreeBlock *block = head;
+  for (u32 i = 1; i < count; ++i) {
+    FreeBlock *next = reinterpret_cast<FreeBlock *>(span + i * classSize);
+    block->Next = next;
+    block = next;
+  }
+  block->Next = nullptr;
+  tail = block;
+  return count;
+}
+
+void *ThreadCachingAllocator::NextSpanLocked() noexcept {
+  if (m_ChunkCursor == m_ChunkEnd) {
+    void *node = m_Upstream->Alloc(sizeof(ChunkNode), alignof(ChunkNode),
+                                   categories::ThreadCachingAllocator);
+    if (!node)
+      return nullptr;
+    auto *base = static_cast<u8 *>(m_Upstream->Alloc(
+        ChunkSize, SpanSize, categories::ThreadCachingAllocator));
+    if (!base || (reinterpret_cast<u64>(base) + ChunkSize) >> AddressBits) {
+      if (base)
+        m_Upstream->Free(base, ChunkSize, SpanSize,
+                         categories::ThreadCachingAllocator);
+      m_Upstream->Free(node, sizeof(ChunkNode), alignof(ChunkNode),
+                       categories::ThreadCachingAllocator);
+      return nullptr;
+    }
+    m_Chunks = new (node) ChunkNode{base, m_Chunks};
+    m_ChunkCursor = base;
+    m_ChunkEnd = base + ChunkSize;
+  }
+
+  void *span = m_ChunkCursor;
+  m_ChunkCursor += SpanSize;
+  m_ReservedBytes.fetch_add(SpanSize, std::memory_order_relaxed);
+  return span;
+}
+
+bool ThreadCachingAllocator::MapSpanLocked(void *span,
+                                           u32 sizeClass) noexcept {
+  u8 **map = m_PageMap.load(std::memory_order_relaxed);
+  if (!map) {
+    map = static_cast<u8 **>(
+        m_Upstream->Alloc(TopSize * sizeof(u8 *), alignof(u8 *),
+                          categories::ThreadCachingAllocator));
+    if (!map)
+      return false;
+    std::memset(map, 0, TopSize * sizeof(u8 *));
+    m_PageMap.store(map, std::memory_order_release);
+  }
+
+  u64 address = reinterpret_cast<u64>(span);
+  std::atomic_ref<u8 *> top(map[address >> (PageShift + LeafBits)]);
+  u8 *leaf = top.load(std::memory_order_relaxed);
+  if (!leaf) {
+    leaf = static_cast<u8 *>(m_Upstream->Alloc(
+        LeafSize, 64, categories::ThreadCachingAllocator));
+    if (!leaf)
+      return false;
+    std::memset(leaf, 0, LeafSize);
+    top.store(leaf, std::memory_order_release);
+  }
+
+  std::atomic_ref<u8>(leaf[(address >> PageShift) & (LeafSize - 1)])
+      .store(static_cast<u8>(sizeClass + 1), std::memory_order_release);
+  return true;
+}
+
+u64 ThreadCachingAllocator::ReservedBytes() const noexcept {
+  return m_ReservedBytes.load(std::memory_order_relaxed);
+}
+
+bool ThreadCachingAllocator::Init() noexcept { return m_Upstream != nullptr; }
+
+void ThreadCachingAllocator::Shutdown() noexcept { FlushThreadCache(); }
+
+} // namespace gecko::runtime
@@ -1,41 +1,301 @@
 #include "gecko/runtime/thread_pool_job_system.h"
 
 #include <algorithm>
+#include <bit>
 #include <chrono>
-#include <functional>
+#include <cstdio>
+#include <iterator>
+#include <new>
+#include <semaphore>
 #include <thread>
+#include <utility>
 
 #include "gecko/core/assert.h"
 #include "gecko/core/log.h"
+#include "gecko/core/memory.h"
 #include "gecko/core/profiler.h"
+#include "gecko/core/thread.h"
+#include "gecko/core/time.h"
+#include "gecko/runtime/cpu_topology.h"
 
+#include "bounded_mpmc_queue.h"
 #include "categories.h"
+#include "job_telemetry.h"
+#include "work_stealing_deque.h"
 
 namespace gecko::runtime {
 
+struct ThreadPoolJobSystem::Group {
+  u8 Index{0};
+  // Threads the group was configured with, not counting spares.
+  u32 ThreadCount{0};
+  std::unique_ptr<BoundedMpmcQueue<Job *>> InjectionQueues[PriorityCount];
+  // Regular workers first, then the elastic and compensation threads.
+  std::vector<Worker *> Workers;
+  std::vector<Worker *> Elastic;
+  std::vector<Worker *> Spares;
+
+  // Regular plus running elastic workers, and how many may run: ThreadCount
+  // plus ElasticThreads, less whatever the CPU quota does not cover.
+  std::atomic<u32> ActiveWorkers{0};
+  std::atomic<u32> WorkerLimit{0};
+  // When the timer thread next looks at growing the group; 0 when no check
+  // is pending.
+  std::atomic<u64> ScaleCheckNs{0};
+
+  // Parked workers; wakers scan from a rotating start to spread wake-ups.
+  std::atomic<u32> ParkedWorkers{0};
+  std::atomic<u32> WakeCursor{0};
+  // Workers currently inside a JobFlags::Blocking job. Spare N runs while
+  // more than N are blocked.
+  std::atomic<u32> BlockedWorkers{0};
+};
+
+struct ThreadPoolJobSystem::Worker {
+  static constexpr u32 NotSpare = ~0u;
+
+  WorkStealingDeque<Job *> Queues[PriorityCount];
+  std::thread Thread;
+  ThreadPoolJobSystem *Owner{nullptr};
+  Group *Home{nullptr};
+  u32 Index{0};      // In m_Workers
+  u32 GroupIndex{0}; // Among the workers of Home
+  u32 SpareRank{NotSpare};
+  u32 StealSeed{0};
+  bool IsElastic{false};
+  // Set by an elastic worker as its thread exits, or before it first
+  // starts. Only the timer thread starts it again.
+  std::atomic<bool> Retired{false};
+
+  // Logical CPUs this worker is pinned to; empty when unpinned.
+  std::vector<u32> Cpus;
+  u32 CacheDomain{0};
+  // Steal victims sharing our last-level cache, then everyone else.
+  std::vector<u32> NearVictims;
+  std::vector<u32> FarVictims;
+
+  // Set while parked, idle or blocked in Wait. Whoever flips it back to
+  // false owns the wake-up and releases Wakeup exactly once.
+  std::atomic<bool> Parked{false};
+  // The job a worker blocked in Wait is waiting for, so its completion can
+  // claim the wake-up too.
+  std::atomic<Job *> BlockedOn{nullptr};
+  // Same protocol for a spare with nothing to compensate for.
+  std::atomic<bool> Dormant{false};
+  std::binary_semaphore Wakeup{0};
+
+  WorkerTelemetry Telemetry;
+  char UtilizationCounter[32]{};
+};
+
+// A periodic job between runs. Only the run in progress touches Function and
+// DeadlineNs; the rest is fixed while Active or guarded by m_TimerMutex.
+struct ThreadPoolJobSystem::PeriodicState {
+  JobFunction Function;
+  JobPriority Priority{JobPriority::Normal};
+  Category Cat{};
+  WorkerGroup Group{WorkerGroup::Default};
+  JobFlags Flags{JobFlags::None};
+  JobThread Thread{};
+  u64 PeriodNs{0};
+  u64 DeadlineNs{0};
+
+  // The next run, waiting in the wheel or queued, or the run in progress.
+  JobHandle Current;
+  // Bumped when the slot is freed so stale PeriodicJob ids miss.
+  u32 Generation{0};
+  bool Active{false};
+  bool Cancelled{false};
+};
+
+// Guarded by m_ResourceMutex. Handles that finished since are left in place
+// and cost nothing as dependencies.
+struct ThreadPoolJobSystem::ResourceSlot {
+  JobHandle Writer;
+  // Readers since Writer; invalid entries are free.
+  JobHandle Readers[ResourceReaderSlots];
+  u32 NextReader{0};
+};
+
+struct ThreadPoolJobSystem::JobThreadState {
+  explicit JobThreadState(u32 capacity) : Queue(capacity) {}
+
+  std::thread::id Owner;
+  u32 Index{0};
+  // Every live job fits, like the injection queues.
+  BoundedMpmcQueue<Job *> Queue;
+
+  // Job the thread is blocked on in Wait. Whoever swaps it back to null owns
+  // the wake-up and releases Wakeup exactly once.
+  std::atomic<Job *> BlockedOn{nullptr};
+  std::binary_semaphore Wakeup{0};
+};
+
+namespace {
+
+thread_local const void *t_CurrentWorker = nullptr;
+thread_local u32 t_StealSeed = 0;
+// Jobs this thread is running in place, nested.
+thread_local u32 t_InlineDepth = 0;
+
+u32 NextRandom(u32 &state) noexcept {
+  // xorshift32; a zero state would get stuck, so reseed it.
+  if (state == 0)
+    state = HashThreadId() | 1u;
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+void LockSuccessors(Job *job) noexcept {
+  while (job->SuccessorLock.test_and_set(std::memory_order_acquire)) {
+    while (job->SuccessorLock.test(std::memory_order_relaxed))
+      CpuRelax();
+  }
+}
+
+void UnlockSuccessors(Job *job) noexcept {
+  job->SuccessorLock.clear(std::memory_order_release);
+}
+
+void FreeOverflowEdges(Job *job) noexcept {
+  if (!job->OverflowEdges)
+    return;
+
+  DeallocBytes(job->OverflowEdges,
+               sizeof(JobDependencyEdge) * job->OverflowEdgeCount,
+               alignof(JobDependencyEdge), categories::Runtime);
+  job->OverflowEdges = nullptr;
+  job->OverflowEdgeCount = 0;
+}
+
+constexpr u64 PackFreeHead(u64 tag, u32 indexPlusOne) noexcept {
+  return (tag << 32) | indexPlusOne;
+}
+
+// Indexed by group
+constexpr const char *ThreadNamePrefixes[] = {"gecko-worker", "gecko-io",
+                                              "gecko-rt"};
+constexpr const char *CounterPrefixes[] = {"worker", "io", "realtime"};
+
+constexpr const char *QueueDepthCounters[] = {
+    "job_queue_depth_low", "job_queue_depth_normal", "job_queue_depth_high"};
+constexpr const char *WaitP50Counters[] = {
+    "job_wait_p50_ns_low", "job_wait_p50_ns_normal", "job_wait_p50_ns_high"};
+constexpr const char *WaitP99Counters[] = {
+    "job_wait_p99_ns_low", "job_wait_p99_ns_normal", "job_wait_p99_ns_high"};
+constexpr const char *RunP99Counters[] = {
+    "job_run_p99_ns_low", "job_run_p99_ns_normal", "job_run_p99_ns_high"};
+
+} // namespace
+
+ThreadPoolJobSystem::ThreadPoolJobSystem() noexcept = default;
+
+ThreadPoolJobSystem::~ThreadPoolJobSystem() { Shutdown(); }
+
+void ThreadPoolJobSystem::SetWorkerGroup(
+    WorkerGroup group, const WorkerGroupConfig &config) noexcept {
+  GECKO_ASSERT(!m_Initialized && "Configure worker groups before Init");
+  GECKO_ASSERT(group != WorkerGroup::Default && "Default is not a group");
+  m_GroupConfigs[GroupIndex(group)] = config;
+}
+
+bool ThreadPoolJobSystem::RouteCategory(Category category,
+                                        WorkerGroup group) noexcept {
+  GECKO_ASSERT(!m_Initialized && "Route categories before Init");
+  for (u32 i = 0; i < m_CategoryRouteCount; ++i) {
+    if (m_CategoryRoutes[i].CategoryId == category.Id) {
+      m_CategoryRoutes[i].Group = static_cast<u8>(GroupIndex(group));
+      return true;
+    }
+  }
+  if (m_CategoryRouteCount == MaxCategoryRoutes)
+    return false;
+  m_CategoryRoutes[m_CategoryRouteCount++] = {
+      category.Id, static_cast<u8>(GroupIndex(group))};
+  return true;
+}
+
 bool ThreadPoolJobSystem::Init() noexcept {
   GECKO_ASSERT(!m_Initialized && "ThreadPoolJobSystem already initialized");
 
-  // Determine worker thread count
-  u32 workerCount = m_RequestedWorkerCount;
-  if (workerCount == 0) {
-    workerCount = std::max(1u, std::thread::hardware_concurrency());
+  m_Shutdown.store(false, std::memory_order_relaxed);
+
+  // Every job slot is allocated up front; Submit only recycles them.
+  m_Jobs = AllocArray<Job>(m_JobCapacity, categories::Runtime);
+  if (!m_Jobs) {
+    std::fprintf(stderr,
+                 "[Gecko] Failed to allocate %u job slots for "
+                 "ThreadPoolJobSystem\n",
+                 m_JobCapacity);
+    return false;
+  }
+  for (u32 i = 0; i < m_JobCapacity; ++i) {
+    Job *job = ::new (&m_Jobs[i]) Job();
+    job->Timer.Context = job;
+    job->NextFree.store(i + 1 < m_JobCapacity ? i + 2 : 0,
+                        std::memory_order_relaxed);
   }
+  m_FreeJobs.store(PackFreeHead(0, 1), std::memory_order_relaxed);
 
   try {
-    m_WorkerThreads.reserve(workerCount);
-    for (u32 i = 0; i < workerCount; ++i) {
-      m_WorkerThreads.emplace_back(&ThreadPoolJobSystem::WorkerThreadFunction,
-                                   this);
+    // Compute always exists; other groups only when they have threads.
+    for (u32 index = 0; index < GroupCount; ++index) {
+      if (index != 0 && m_GroupConfigs[index].ThreadCount == 0)
+        continue;
+      auto group = std::make_unique<Group>();
+      group->Index = static_cast<u8>(index);
+      // Every live job fits in an injection queue.
+      for (auto &queue : group->InjectionQueues)
+        queue = std::make_unique<BoundedMpmcQueue<Job *>>(m_JobCapacity);
+      m_Groups[index] = std::move(group);
     }
 
+    // All workers must exist before any thread starts so thieves can scan
+    // m_Workers without synchronization.
+    PlaceWorkers();
+    BuildStealOrder();
+
+    for (auto &worker : m_Workers) {
+      std::snprintf(worker->UtilizationCounter,
+                    sizeof(worker->UtilizationCounter), "%s_%u_busy_pct",
+                    CounterPrefixes[worker->Home->Index], worker->GroupIndex);
+    }
+    m_Resources = std::make_unique<ResourceSlot[]>(ResourceSlotCount);
+    m_TimerWheel = std::make_unique<TimerWheel>(MonotonicTimeNs());
+    m_Periodic = std::make_unique<PeriodicState[]>(MaxPeriodicJobs);
+    m_TimerWakeNs = 0;
+    m_TimerStop = false;
+
+    m_ExternalTelemetry = std::make_unique<WorkerTelemetry>();
+    m_TelemetryCurrent = std::make_unique<JobSystemTelemetry>();
+    m_TelemetryPrevious = std::make_unique<JobSystemTelemetry>();
+    for (auto *snapshot :
+         {m_TelemetryCurrent.get(), m_TelemetryPrevious.get()}) {
+      snapshot->Workers.reserve(m_Workers.size());
+      snapshot->ByCategory.reserve(WorkerTelemetry::CategorySlotCount);
+    }
+    m_InitNs = MonotonicTimeNs();
+    m_NextTelemetryNs.store(m_InitNs + m_TelemetryIntervalNs,
+                            std::memory_order_relaxed);
+
     m_Initialized = true;
+    for (auto &worker : m_Workers) {
+      if (worker->IsElastic)
+        continue;
+      worker->Thread = std::thread(&ThreadPoolJobSystem::WorkerThreadFunction,
+                                   this, worker.get());
+    }
+    m_TimerThread =
+        std::thread(&ThreadPoolJobSystem::TimerThreadFunction, this);
     return true;
   } catch (...) {
     // Use direct fprintf during Init() since Logger may not be available yet
     std::fprintf(
         stderr,
         "[Gecko] Failed to create worker threads for ThreadPoolJobSystem\n");
+    m_Initialized = true;
     Shutdown();
     return false;
   }
@@ -45,254 +305,1765 @@ void ThreadPoolJobSystem::Shutdown() noexcept {
   if (!m_Initialized)
     return;
 
+  // Timers stop first. Jobs still waiting on a deadline are dropped with the
+  // pool, like anything else left in a queue.
+  {
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    m_TimerStop = true;
+  }
+  m_TimerWake.notify_one();
+  if (m_TimerThread.joinable())
+    m_TimerThread.join();
+
   m_Shutdown.store(true, std::memory_order_release);
-  m_JobAvailable.notify_all();
+  // Pairs with the fences in Park and GoDormant.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  for (auto &worker : m_Workers) {
+    if (worker->Dormant.exchange(false, std::memory_order_acq_rel))
+      worker->Wakeup.release();
+  }
+  WakeAllGroups(false);
 
-  for (auto &thread : m_WorkerThreads) {
-    if (thread.joinable()) {
-      thread.join();
+  for (auto &worker : m_Workers) {
+    if (worker->Thread.joinable()) {
+      worker->Thread.join();
     }
   }
 
-  m_WorkerThreads.clear();
+  m_Workers.clear();
+  for (auto &group : m_Groups)
+    group.reset();
+  m_TimerWheel.reset();
+  m_Periodic.reset();
+  m_Resources.reset();
+  // Jobs still queued for a registered thread are dropped with the pool.
+  m_JobThreadCount.store(0, std::memory_order_relaxed);
+  for (auto &thread : m_JobThreads)
+    thread.reset();
+  m_ExternalTelemetry.reset();
+  m_TelemetryCurrent.reset();
+  m_TelemetryPrevious.reset();
 
-  {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    // Clear remaining jobs
-    while (!m_JobQueue.empty()) {
-      m_JobQueue.pop();
+  // Handles stop resolving first: destroying a job function can release a
+  // hold (see JobGroup) on a slot that is going away too.
+  if (Job *jobs = std::exchange(m_Jobs, nullptr)) {
+    for (u32 i = 0; i < m_JobCapacity; ++i) {
+      // Results whose futures outlive the pool go with it.
+      if (jobs[i].Result)
+        jobs[i].DestroyResult(jobs[i].Result);
+      FreeOverflowEdges(&jobs[i]);
+      jobs[i].~Job();
     }
-    m_ActiveJobs.clear();
+    DeallocBytes(jobs, sizeof(Job) * m_JobCapacity, alignof(Job),
+                 categories::Runtime);
   }
+  m_FreeJobs.store(0, std::memory_order_relaxed);
 
   m_Initialized = false;
 }
 
 JobHandle ThreadPoolJobSystem::Submit(JobFunction job, JobPriority priority,
                                       Category category) noexcept {
+  return Submit(std::move(job), nullptr, 0, priority, category);
+}
+
+JobHandle ThreadPoolJobSystem::Submit(JobFunction job,
+                                      const JobHandle *dependencies,
+                                      u32 dependencyCount, JobPriority priority,
+                                      Category category) noexcept {
   if (!m_Initialized || !job)
     return JobHandle{};
 
-  JobHandle handle = GenerateJobHandle();
-  auto jobPtr =
-      std::make_shared<Job>(std::move(job), priority, category, handle);
+  JobDesc desc;
+  desc.Function = std::move(job);
+  desc.Dependencies = dependencies;
+  desc.DependencyCount = dependencyCount;
+  desc.Priority = priority;
+  desc.Cat = category;
+  Job *newJob = PrepareJob(desc);
+  if (!newJob)
+    return JobHandle{};
+
+  // Read the handle first: once queued the job may finish and be recycled.
+  const JobHandle handle = newJob->Handle;
+  if (ReleaseSubmitReference(newJob))
+    Dispatch(newJob);
+  return handle;
+}
+
+void ThreadPoolJobSystem::SubmitBatch(JobDesc *jobs, u32 count,
+                                      JobHandle *outHandles) noexcept {
+  GECKO_PROF_SCOPE(categories::Runtime, "ThreadPoolJobSystem::SubmitBatch");
+
+  u32 readyCount[GroupCount]{};
+  for (u32 i = 0; i < count; ++i) {
+    JobDesc &desc = jobs[i];
+    Job *newJob = nullptr;
+    if (m_Initialized && desc.Function)
+      newJob = PrepareJob(desc);
+
+    const JobHandle handle = newJob ? newJob->Handle : JobHandle{};
+    if (outHandles)
+      outHandles[i] = handle;
+
+    if (!newJob || !ReleaseSubmitReference(newJob))
+      continue;
+
+    if (newJob->Thread != 0) {
+      PushToThread(newJob);
+    } else if (ShouldRunInline(newJob)) {
+      RunInline(newJob);
+    } else {
+      // Read before queueing; the job may run and be recycled right away.
+      ++readyCount[newJob->Group];
+      PushReady(newJob);
+    }
+  }
 
+  for (u32 index = 0; index < GroupCount; ++index) {
+    if (readyCount[index] > 0)
+      WakeWorkers(*m_Groups[index], readyCount[index]);
+  }
+}
+
+JobHandle ThreadPoolJobSystem::SubmitAt(JobDesc desc, u64 deadlineNs) noexcept {
+  if (!m_Initialized || !desc.Function)
+    return JobHandle{};
+
+  Job *newJob = PrepareJob(desc);
+  if (!newJob)
+    return JobHandle{};
+
+  // The timer keeps the submit reference until the deadline, so the job
+  // becomes ready once both the deadline and its dependencies have passed.
+  const JobHandle handle = newJob->Handle;
+  if (!ArmTimer(newJob, deadlineNs) && ReleaseSubmitReference(newJob))
+    Enqueue(newJob);
+  return handle;
+}
+
+PeriodicJob ThreadPoolJobSystem::SubmitPeriodic(JobDesc desc,
+                                                u64 periodNs) noexcept {
+  GECKO_ASSERT(periodNs > 0 && "Periodic jobs need a period");
+  if (!m_Initialized || !desc.Function || periodNs == 0)
+    return PeriodicJob{};
+
+  PeriodicState *state = nullptr;
+  PeriodicJob job;
   {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    m_ActiveJobs[handle.Id] = jobPtr;
-    m_JobQueue.push(jobPtr);
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    for (u32 index = 0; index < MaxPeriodicJobs && !state; ++index) {
+      if (!m_Periodic[index].Active) {
+        state = &m_Periodic[index];
+        job.Id = (static_cast<u64>(state->Generation) << 32) | (index + 1);
+      }
+    }
+    if (state) {
+      state->Function = std::move(desc.Function);
+      if (state->Function.UsesHeap())
+        m_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+      state->Priority = desc.Priority;
+      state->Cat = desc.Cat;
+      state->Group = desc.Group;
+      state->Flags = desc.Flags;
+      state->Thread = desc.Thread;
+      state->PeriodNs = periodNs;
+      state->DeadlineNs = MonotonicTimeNs() + periodNs;
+      state->Current = JobHandle{};
+      state->Active = true;
+      state->Cancelled = false;
+    }
+  }
+
+  // Logged outside the lock: the logger submits its consumer through the
+  // timer.
+  if (!state) {
+    GECKO_WARN(categories::Runtime, "Cannot run more than %u periodic jobs",
+               MaxPeriodicJobs);
+    return PeriodicJob{};
   }
 
-  m_JobAvailable.notify_one();
+  SchedulePeriodic(*state);
+  return job;
+}
+
+void ThreadPoolJobSystem::CancelPeriodic(PeriodicJob job) noexcept {
+  const u32 indexPlusOne = static_cast<u32>(job.Id);
+  if (!m_Initialized || indexPlusOne == 0 || indexPlusOne > MaxPeriodicJobs)
+    return;
+
+  PeriodicState &state = m_Periodic[indexPlusOne - 1];
+  JobHandle current;
+  Job *pending = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    if (!state.Active || state.Cancelled ||
+        state.Generation != static_cast<u32>(job.Id >> 32))
+      return;
+    state.Cancelled = true;
+    current = state.Current;
 
-  // Don't trace logger jobs to avoid feedback loops
-  if (category != categories::Logger) {
+    // A run still in the wheel has not been released to anyone yet, so it
+    // can be dropped right here.
+    u32 generation = 0;
+    Job *next = ResolveHandle(current, generation);
+    if (next && next->Timer.IsLinked() &&
+        next->Generation.load(std::memory_order_relaxed) == generation) {
+      m_TimerWheel->Remove(&next->Timer);
+      pending = next;
+    }
   }
-  return handle;
+
+  if (pending)
+    CompleteJob(pending, true);
+  else
+    Wait(current);
+
+  std::lock_guard<std::mutex> lock(m_TimerMutex);
+  state.Function = nullptr;
+  state.Current = JobHandle{};
+  state.Active = false;
+  ++state.Generation;
 }
 
-JobHandle ThreadPoolJobSystem::Submit(JobFunction job,
-                                      const JobHandle *dependencies,
-                                      u32 dependencyCount, JobPriority priority,
-                                      Category category) noexcept {
-  if (!m_Initialized || !job)
-    return JobHandle{};
+Job *ThreadPoolJobSystem::PrepareJob(JobDesc &desc,
+                                     const JobResultDesc *result) noexcept {
+  // Declared resources can add a bounded number of dependencies; the usual
+  // handful fits on the stack.
+  constexpr u32 InlineInferred = 64;
+  JobHandle inlineInferred[InlineInferred];
+  JobHandle *inferred = inlineInferred;
+  const u32 maxInferred =
+      desc.WriteCount * (ResourceReaderSlots + 1) + desc.ReadCount * 2;
+  if (maxInferred > InlineInferred) {
+    inferred = AllocArray<JobHandle>(maxInferred, categories::Runtime);
+    if (!inferred)
+      return nullptr;
+    m_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  Job *newJob = AcquireJob();
+  if (!newJob) {
+    if (inferred != inlineInferred)
+      DeallocBytes(inferred, sizeof(JobHandle) * maxInferred,
+                   alignof(JobHandle), categories::Runtime);
+    return nullptr;
+  }
+
+  // The function can only be built once it knows where its result goes.
+  if (result) {
+    void *storage = result->Buffer ? result->Buffer : newJob->ResultStorage;
+    newJob->Result = storage;
+    newJob->DestroyResult = result->Destroy;
+    newJob->ResultReferences.store(2, std::memory_order_relaxed);
+    desc.Function = result->Bind(result->Context, storage);
+  }
+
+  // JobThread ids are index + 1; unknown ones fall back to the pool.
+  const u32 threadCount = m_JobThreadCount.load(std::memory_order_acquire);
+  GECKO_ASSERT(desc.Thread.Id <= threadCount && "Unknown JobThread");
+
+  newJob->Function = std::move(desc.Function);
+  if (newJob->Function.UsesHeap())
+    m_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+  newJob->Priority = desc.Priority;
+  newJob->Cat = desc.Cat;
+  newJob->Group = ResolveGroup(desc.Group, desc.Cat);
+  newJob->Thread =
+      desc.Thread.Id <= threadCount ? static_cast<u8>(desc.Thread.Id) : 0;
+  newJob->Flags = desc.Flags;
+  newJob->Cancellation = desc.Cancellation;
+  newJob->DependencyCancelled.store(false, std::memory_order_relaxed);
 
-  JobHandle handle = GenerateJobHandle();
-  auto jobPtr =
-      std::make_shared<Job>(std::move(job), priority, category, handle);
+  const JobHandle *dependencies = desc.Dependencies;
+  const u32 dependencyCount = desc.DependencyCount;
+  newJob->Handle = MakeHandle(newJob);
+  newJob->SubmitNs = MonotonicTimeNs();
 
-  // Copy dependencies
-  if (dependencies && dependencyCount > 0) {
-    jobPtr->Dependencies.reserve(dependencyCount);
+  const u32 inferredCount =
+      maxInferred > 0 ? InferDependencies(desc, newJob->Handle, inferred) : 0;
+
+  u32 edgeCount = inferredCount;
+  if (dependencies) {
     for (u32 i = 0; i < dependencyCount; ++i) {
-      if (dependencies[i].IsValid()) {
-        jobPtr->Dependencies.push_back(dependencies[i]);
+      if (dependencies[i].IsValid())
+        ++edgeCount;
+    }
+  }
+
+  JobDependencyEdge *edges = newJob->InlineEdges;
+  if (edgeCount > Job::InlineDependencyCount) {
+    edges = AllocArray<JobDependencyEdge>(edgeCount, categories::Runtime);
+    if (edges) {
+      newJob->OverflowEdges = edges;
+      newJob->OverflowEdgeCount = edgeCount;
+      m_HeapAllocations.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      // Out of memory for edges: satisfy the dependencies up front instead.
+      WaitAll(dependencies, dependencyCount);
+      WaitAll(inferred, inferredCount);
+      edgeCount = 0;
+    }
+  }
+
+  // Dependencies that already finished have moved on to a newer generation
+  // and cost nothing; the rest record us as a successor.
+  u32 usedEdges = 0;
+  if (dependencies) {
+    for (u32 i = 0; i < dependencyCount && usedEdges < edgeCount; ++i) {
+      if (AddSuccessor(dependencies[i], newJob, &edges[usedEdges]))
+        ++usedEdges;
+    }
+  }
+  for (u32 i = 0; i < inferredCount && usedEdges < edgeCount; ++i) {
+    if (AddSuccessor(inferred[i], newJob, &edges[usedEdges]))
+      ++usedEdges;
+  }
+
+  if (inferred != inlineInferred)
+    DeallocBytes(inferred, sizeof(JobHandle) * maxInferred,
+                 alignof(JobHandle), categories::Runtime);
+  return newJob;
+}
+
+u32 ThreadPoolJobSystem::InferDependencies(const JobDesc &desc,
+                                           JobHandle self,
+                                           JobHandle *out) noexcept {
+  auto slotOf = [this](u64 resource) -> ResourceSlot & {
+    // Fibonacci hashing spreads sequential ids and pointers alike.
+    constexpr u32 Shift = 64 - std::countr_zero(ResourceSlotCount);
+    return m_Resources[(resource * 0x9E3779B97F4A7C15ull) >> Shift];
+  };
+
+  // One lock for the whole set: two jobs that each write what the other
+  // writes must see each other in the same order everywhere, or they would
+  // wait on each other.
+  u32 count = 0;
+  std::lock_guard<std::mutex> lock(m_ResourceMutex);
+
+  // Writes first, so a resource the job also reads is simply written.
+  for (u32 i = 0; i < desc.WriteCount; ++i) {
+    ResourceSlot &slot = slotOf(desc.Writes[i]);
+    if (slot.Writer == self)
+      continue;
+    if (slot.Writer.IsValid())
+      out[count++] = slot.Writer;
+    for (JobHandle &reader : slot.Readers) {
+      if (reader.IsValid() && reader != self)
+        out[count++] = reader;
+      reader = JobHandle{};
+    }
+    slot.Writer = self;
+  }
+
+  for (u32 i = 0; i < desc.ReadCount; ++i) {
+    ResourceSlot &slot = slotOf(desc.Reads[i]);
+    if (slot.Writer == self ||
+        std::find(std::begin(slot.Readers), std::end(slot.Readers), self) !=
+            std::end(slot.Readers))
+      continue;
+    if (slot.Writer.IsValid())
+      out[count++] = slot.Writer;
+
+    // Take a free or finished place. When all are busy, the reader whose
+    // place we take must finish before us, so the next writer still waits
+    // for it through us.
+    JobHandle *place = nullptr;
+    for (JobHandle &reader : slot.Readers) {
+      if (!reader.IsValid() || IsComplete(reader)) {
+        place = &reader;
+        break;
       }
     }
+    if (!place) {
+      place = &slot.Readers[slot.NextReader];
+      slot.NextReader = (slot.NextReader + 1) % ResourceReaderSlots;
+      out[count++] = *place;
+    }
+    *place = self;
   }
+  return count;
+}
 
-  {
-    std::lock_guard<std::mutex> lock(m_Mutex);
-    m_ActiveJobs[handle.Id] = jobPtr;
-    m_JobQueue.push(jobPtr);
+u8 ThreadPoolJobSystem::ResolveGroup(WorkerGroup group,
+                                     Category category) const noexcept {
+  u32 index = GroupIndex(group);
+  if (group == WorkerGroup::Default) {
+    for (u32 i = 0; i < m_CategoryRouteCount; ++i) {
+      if (m_CategoryRoutes[i].CategoryId == category.Id) {
+        index = m_CategoryRoutes[i].Group;
+        break;
+      }
+    }
+  }
+  // Groups without threads fall back to Compute
+  return m_Groups[index] ? static_cast<u8>(index) : 0;
+}
+
+bool ThreadPoolJobSystem::ReleaseSubmitReference(Job *job) noexcept {
+  // If every dependency is already done we are the last reference and the
+  // job is ready now.
+  return job->PendingDependencies.fetch_sub(1, std::memory_order_acq_rel) ==
+         1;
+}
+
+JobHandle ThreadPoolJobSystem::SubmitHeld(JobDesc desc) noexcept {
+  // Holds share the counter with dependencies: the submit reference is the
+  // first hold.
+  Job *newJob = m_Initialized ? PrepareJob(desc) : nullptr;
+  if (newJob)
+    return newJob->Handle;
+
+  // Nothing to hold it in: run it here once its dependencies are done, as
+  // the interface promises. PrepareJob leaves the function in place when it
+  // fails.
+  if (m_Initialized)
+    WaitAll(desc.Dependencies, desc.DependencyCount);
+  const CancellationToken *token = desc.Cancellation;
+  if (desc.Function && !(token && token->IsCancelled())) {
+    try {
+      desc.Function();
+    } catch (...) {
+      GECKO_ERROR(categories::Runtime,
+                  "Held job threw an exception on thread %u", ThisThreadId());
+    }
+  }
+  return JobHandle{};
+}
+
+bool ThreadPoolJobSystem::AddHold(JobHandle handle) noexcept {
+  u32 generation = 0;
+  Job *job = ResolveHandle(handle, generation);
+  if (!job)
+    return false;
+
+  // Under the successor lock the job cannot complete, so a matching
+  // generation means the slot is still ours. A non-zero count means it has
+  // not been queued yet.
+  bool added = false;
+  LockSuccessors(job);
+  if (job->Generation.load(std::memory_order_relaxed) == generation) {
+    u32 pending = job->PendingDependencies.load(std::memory_order_relaxed);
+    while (pending != 0 && !job->PendingDependencies.compare_exchange_weak(
+                               pending, pending + 1,
+                               std::memory_order_relaxed))
+      ;
+    added = pending != 0;
   }
+  UnlockSuccessors(job);
+  return added;
+}
+
+void ThreadPoolJobSystem::ReleaseHold(JobHandle handle) noexcept {
+  u32 generation = 0;
+  Job *job = ResolveHandle(handle, generation);
+  if (!job)
+    return;
+  GECKO_ASSERT(job->Generation.load(std::memory_order_relaxed) == generation &&
+               "Released a hold on a finished job");
 
-  m_JobAvailable.notify_one();
+  if (!ReleaseSubmitReference(job))
+    return;
+  // A job without a function has nothing to queue for.
+  if (job->Function)
+    Enqueue(job);
+  else
+    CompleteJob(job, IsCancelled(job));
+}
 
-  // Don't trace logger jobs to avoid feedback loops
-  if (category != categories::Logger) {
+JobHandle ThreadPoolJobSystem::SubmitWithResult(JobDesc desc,
+                                                const JobResultDesc &result,
+                                                void *&outStorage) noexcept {
+  outStorage = nullptr;
+  if (!m_Initialized || !result.Bind)
+    return JobHandle{};
+  if (!result.Buffer && (result.Size > JobResultCapacity ||
+                         result.Alignment > JobResultAlignment)) {
+    GECKO_ASSERT(false && "Job result does not fit in a job slot");
+    return JobHandle{};
   }
+
+  Job *newJob = PrepareJob(desc, &result);
+  if (!newJob)
+    return JobHandle{};
+
+  outStorage = newJob->Result;
+  const JobHandle handle = newJob->Handle;
+  if (ReleaseSubmitReference(newJob))
+    Dispatch(newJob);
   return handle;
 }
 
+void ThreadPoolJobSystem::ReleaseResult(JobHandle handle, void *storage,
+                                        const JobResultDesc &) noexcept {
+  // The slot cannot have been reused while the future held it, so the
+  // index alone finds it even after the generation has moved on.
+  u32 generation = 0;
+  Job *job = ResolveHandle(handle, generation);
+  if (!job)
+    return;
+
+  GECKO_ASSERT(job->Result == storage && "Result released twice");
+  if (job->ResultReferences.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    RecycleJob(job);
+}
+
 void ThreadPoolJobSystem::Wait(JobHandle handle) noexcept {
-  if (!handle.IsValid())
+  u32 generation = 0;
+  Job *job = ResolveHandle(handle, generation);
+  if (!job || job->Generation.load(std::memory_order_acquire) != generation)
     return;
 
   GECKO_PROF_SCOPE(categories::Runtime, "ThreadPoolJobSystem::Wait");
 
-  std::unique_lock<std::mutex> lock(m_Mutex);
-  m_JobCompleted.wait(lock, [this, handle]() {
-    auto it = m_ActiveJobs.find(handle.Id);
-    return it == m_ActiveJobs.end() ||
-           it->second->Completed.load(std::memory_order_acquire);
-  });
+  // Help first: anything runnable might be what we are waiting for, and
+  // running it here beats a context switch.
+  Worker *self = CurrentWorker();
+  JobThreadState *thread = self ? nullptr : CurrentJobThread();
+  while (job->Generation.load(std::memory_order_acquire) == generation) {
+    if (Job *ready = GetNextReadyJob(self)) {
+      Execute(ready);
+      continue;
+    }
+
+    // Workers block as if parked, so new work in their group wakes them
+    // too: the job they wait on may only become runnable after work that
+    // needs a free worker.
+    if (self)
+      BlockWorker(*self, job, generation);
+    else if (thread)
+      BlockJobThread(*thread, job, generation);
+    else
+      BlockUntilComplete(job, generation);
+  }
 }
 
 void ThreadPoolJobSystem::WaitAll(const JobHandle *handles,
                                   u32 count) noexcept {
-  if (!handles || count == 0)
+  if (!handles)
     return;
 
-  GECKO_PROF_SCOPE(categories::Runtime, "ThreadPoolJobSystem::WaitAll");
-
-  std::unique_lock<std::mutex> lock(m_Mutex);
-  m_JobCompleted.wait(lock, [this, handles, count]() {
-    for (u32 i = 0; i < count; ++i) {
-      if (!handles[i].IsValid())
-        continue;
-
-      auto it = m_ActiveJobs.find(handles[i].Id);
-      if (it != m_ActiveJobs.end() &&
-          !it->second->Completed.load(std::memory_order_acquire)) {
-        return false;
-      }
-    }
-    return true;
-  });
+  // Each Wait helps and blocks on its own job, so a thread is woken at most
+  // once per handle rather than once per completion anywhere in the pool.
+  for (u32 i = 0; i < count; ++i)
+    Wait(handles[i]);
 }
 
 bool ThreadPoolJobSystem::IsComplete(JobHandle handle) noexcept {
-  if (!handle.IsValid())
-    return true;
-
-  std::lock_guard<std::mutex> lock(m_Mutex);
-  auto it = m_ActiveJobs.find(handle.Id);
-  return it == m_ActiveJobs.end() ||
-         it->second->Completed.load(std::memory_order_acquire);
+  u32 generation = 0;
+  Job *job = ResolveHandle(handle, generation);
+  return !job ||
+         job->Generation.load(std::memory_order_acquire) != generation;
 }
 
 u32 ThreadPoolJobSystem::WorkerThreadCount() const noexcept {
-  return static_cast<u32>(m_WorkerThreads.size());
+  return WorkerGroupThreadCount(WorkerGroup::Compute);
+}
+
+u32 ThreadPoolJobSystem::WorkerGroupThreadCount(
+    WorkerGroup group) const noexcept {
+  const Group *entry = m_Groups[GroupIndex(group)].get();
+  return entry ? entry->ThreadCount : 0;
+}
+
+u32 ThreadPoolJobSystem::ActiveWorkerCount(WorkerGroup group) const noexcept {
+  const Group *entry = m_Groups[GroupIndex(group)].get();
+  return entry ? entry->ActiveWorkers.load(std::memory_order_relaxed) : 0;
 }
 
 void ThreadPoolJobSystem::ProcessJobs(u32 maxJobs) noexcept {
   GECKO_PROF_SCOPE(categories::Runtime, "ThreadPoolJobSystem::ProcessJobs");
 
+  Worker *self = CurrentWorker();
   for (u32 processed = 0; processed < maxJobs; ++processed) {
-    auto job = GetNextReadyJob();
+    Job *job = GetNextReadyJob(self);
     if (!job)
       break;
 
-    try {
-      GECKO_PROF_SCOPE(categories::Runtime, "Job::Execute");
-      GECKO_PROF_COUNTER(categories::Runtime, "jobs_processed", 1);
+    Execute(job);
+  }
+}
 
-      job->Function();
-      job->Completed.store(true, std::memory_order_release);
+JobThread ThreadPoolJobSystem::RegisterThread() noexcept {
+  // Workers never drain a thread queue
+  GECKO_ASSERT(!CurrentWorker() && "Worker threads cannot be job threads");
+  if (!m_Initialized || CurrentWorker())
+    return JobThread{};
+  if (JobThreadState *thread = CurrentJobThread())
+    return JobThread{thread->Index + 1};
 
-    } catch (...) {
-      job->Completed.store(true, std::memory_order_release);
+  std::lock_guard<std::mutex> lock(m_RegisterMutex);
+  const u32 count = m_JobThreadCount.load(std::memory_order_relaxed);
+  if (count == MaxJobThreads) {
+    GECKO_WARN(categories::Runtime,
+               "Cannot register more than %u job threads", MaxJobThreads);
+    return JobThread{};
+  }
+
+  try {
+    auto thread = std::make_unique<JobThreadState>(m_JobCapacity);
+    thread->Owner = std::this_thread::get_id();
+    thread->Index = count;
+    m_JobThreads[count] = std::move(thread);
+  } catch (...) {
+    return JobThread{};
+  }
+
+  // Publishes the entry to CurrentJobThread and PrepareJob.
+  m_JobThreadCount.store(count + 1, std::memory_order_release);
+  return JobThread{count + 1};
+}
+
+void ThreadPoolJobSystem::PlaceWorkers() {
+  CpuTopology topology;
+  if (m_Pinning != WorkerPinning::None)
+    topology = DetectCpuTopology();
+  const u32 quota = m_ScalingPolicy.RespectCpuQuota ? DetectCpuQuota() : 0;
+
+  // One placement slot per pinning unit, in topology order so consecutive
+  // workers share caches.
+  std::vector<std::vector<u32>> slots;
+  std::vector<u32> slotDomains;
+  for (const CpuInfo &cpu : topology.Cpus) {
+    const bool newCore = cpu.SmtIndex == 0 || slots.empty();
+    if (m_Pinning == WorkerPinning::HardwareThreads || newCore) {
+      slots.emplace_back();
+      slotDomains.push_back(cpu.CacheDomain);
     }
+    slots.back().push_back(cpu.Id);
+  }
+
+  for (u32 index = 0; index < GroupCount; ++index) {
+    Group *group = m_Groups[index].get();
+    if (!group)
+      continue;
 
-    {
-      std::lock_guard<std::mutex> lock(m_Mutex);
-      m_ActiveJobs.erase(job->Handle.Id);
+    const WorkerGroupConfig &config = m_GroupConfigs[index];
+    u32 threadCount = config.ThreadCount;
+    if (threadCount == 0) {
+      threadCount = slots.empty()
+                        ? std::max(1u, std::thread::hardware_concurrency())
+                        : static_cast<u32>(slots.size());
+      if (index == 0 && quota != 0)
+        threadCount = std::min(threadCount, quota);
     }
+    group->ThreadCount = threadCount;
+
+    const u32 running = threadCount + config.ElasticThreads;
+    group->ActiveWorkers.store(threadCount, std::memory_order_relaxed);
+    const u32 limit = index == 0 && quota != 0
+                          ? std::max(threadCount, std::min(running, quota))
+                          : running;
+    group->WorkerLimit.store(limit, std::memory_order_relaxed);
 
-    m_JobCompleted.notify_all();
+    const u32 total = running + config.CompensationThreads;
+    for (u32 i = 0; i < total; ++i) {
+      auto worker = std::make_unique<Worker>();
+      worker->Owner = this;
+      worker->Home = group;
+      worker->Index = static_cast<u32>(m_Workers.size());
+      worker->GroupIndex = i;
+      worker->StealSeed = (worker->Index + 1) * 2654435761u;
+      // Only compute workers are pinned: they are the ones that should own
+      // a core. More workers than slots wrap around and share them.
+      if (index == 0 && i < running && !slots.empty()) {
+        worker->Cpus = slots[i % slots.size()];
+        worker->CacheDomain = slotDomains[i % slots.size()];
+      }
+      if (i >= running) {
+        worker->SpareRank = i - running;
+        group->Spares.push_back(worker.get());
+      } else if (i >= threadCount) {
+        // Elastic workers start retired; the timer thread brings them in.
+        worker->IsElastic = true;
+        worker->Retired.store(true, std::memory_order_relaxed);
+        group->Elastic.push_back(worker.get());
+      }
+      group->Workers.push_back(worker.get());
+      m_Workers.push_back(std::move(worker));
+    }
   }
 }
 
-void ThreadPoolJobSystem::WorkerThreadFunction() noexcept {
+void ThreadPoolJobSystem::BuildStealOrder() noexcept {
+  for (auto &worker : m_Workers) {
+    for (auto &victim : m_Workers) {
+      if (victim == worker || victim->Home != worker->Home)
+        continue;
+      if (victim->CacheDomain == worker->CacheDomain)
+        worker->NearVictims.push_back(victim->Index);
+      else
+        worker->FarVictims.push_back(victim->Index);
+    }
+  }
+}
+
+void ThreadPoolJobSystem::WorkerThreadFunction(Worker *worker) noexcept {
   GECKO_PROF_SCOPE(categories::Runtime, "WorkerThread");
 
+  t_CurrentWorker = worker;
   const u32 threadId = ThisThreadId();
 
-  while (!m_Shutdown.load(std::memory_order_acquire)) {
-    auto job = GetNextReadyJob();
-    if (!job) {
-      // No jobs available, wait for notification
-      std::unique_lock<std::mutex> lock(m_Mutex);
-      m_JobAvailable.wait_for(lock, std::chrono::milliseconds(100), [this]() {
-        return m_Shutdown.load(std::memory_order_acquire) ||
-               !m_JobQueue.empty();
-      });
+  char name[16];
+  std::snprintf(name, sizeof(name), "%s-%u",
+                ThreadNamePrefixes[worker->Home->Index], worker->GroupIndex);
+  SetCurrentThreadName(name);
+  if (!worker->Cpus.empty() &&
+      !PinCurrentThread(worker->Cpus.data(),
+                        static_cast<u32>(worker->Cpus.size()))) {
+    GECKO_WARN(categories::Runtime, "Failed to pin worker %u to CPU %u",
+               worker->Index, worker->Cpus.front());
+  }
+
+  const bool spare = worker->SpareRank != Worker::NotSpare;
+  if (spare)
+    GoDormant(worker);
+
+  bool retired = false;
+  while (!retired && !m_Shutdown.load(std::memory_order_acquire)) {
+    Job *job = GetNextReadyJob(worker);
+    if (job) {
+      Execute(job);
+      // The CPU quota may have shrunk below what is running.
+      if (worker->IsElastic && ShouldRetire(*worker->Home)) {
+        retired = true;
+        continue;
+      }
+    }
+
+    // A spare checks only after looking for work: a wake-up meant for a job
+    // must not be dropped.
+    if (spare && !IsSpareNeeded(worker))
+      GoDormant(worker);
+    else if (!job)
+      retired = !Idle(worker);
+  }
+
+  t_CurrentWorker = nullptr;
+  if (retired) {
+    m_WorkersRetired.fetch_add(1, std::memory_order_relaxed);
+    GECKO_TRACE(categories::Runtime, "Elastic worker thread %u retiring",
+                threadId);
+    worker->Retired.store(true, std::memory_order_release);
+    return;
+  }
+  GECKO_TRACE(categories::Runtime, "Worker thread %u exiting", threadId);
+}
+
+bool ThreadPoolJobSystem::Idle(Worker *worker) noexcept {
+  auto hasWork = [this, worker]() {
+    return m_Shutdown.load(std::memory_order_acquire) ||
+           HasQueuedJobs(*worker->Home);
+  };
+
+  // Spin first: a burst that arrives within the window is picked up without
+  // a kernel round trip. The clock is only read between short CpuRelax runs.
+  const u64 spinUntil = MonotonicTimeNs() + m_IdlePolicy.SpinNs;
+  while (m_IdlePolicy.SpinNs > 0) {
+    if (hasWork())
+      return true;
+    for (u32 i = 0; i < 32; ++i)
+      CpuRelax();
+    if (MonotonicTimeNs() >= spinUntil)
+      break;
+  }
+
+  for (u32 i = 0; i < m_IdlePolicy.YieldCount; ++i) {
+    if (hasWork())
+      return true;
+    YieldThread();
+  }
+
+  return Park(worker);
+}
+
+bool ThreadPoolJobSystem::Park(Worker *worker) noexcept {
+  m_WorkerParks.fetch_add(1, std::memory_order_relaxed);
+  Group &group = *worker->Home;
+
+  // Announcing ourselves before the final queue check pairs with the fence
+  // in WakeWorkers: either the waker sees us parked, or we see its job.
+  worker->Parked.store(true, std::memory_order_relaxed);
+  group.ParkedWorkers.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (m_Shutdown.load(std::memory_order_acquire) || HasQueuedJobs(group)) {
+    if (worker->Parked.exchange(false, std::memory_order_acq_rel)) {
+      group.ParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+      return true;
+    }
+    // A waker claimed us in the meantime; consume its release below so the
+    // semaphore stays balanced.
+  }
+
+  GECKO_PROF_SCOPE(categories::Runtime, "WorkerParked");
+  if (!worker->IsElastic) {
+    worker->Wakeup.acquire();
+    return true;
+  }
+
+  // Elastic workers give up after RetireIdleNs. Unparking ourselves settles
+  // the race with a waker the same way as above.
+  const std::chrono::nanoseconds timeout(m_ScalingPolicy.RetireIdleNs);
+  if (worker->Wakeup.try_acquire_for(timeout))
+    return true;
+  if (!worker->Parked.exchange(false, std::memory_order_acq_rel)) {
+    worker->Wakeup.acquire();
+    return true;
+  }
+  group.ParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+  if (m_Shutdown.load(std::memory_order_acquire) || HasQueuedJobs(group))
+    return true;
+  group.ActiveWorkers.fetch_sub(1, std::memory_order_relaxed);
+  return false;
+}
+
+bool ThreadPoolJobSystem::ShouldRetire(Group &group) noexcept {
+  u32 active = group.ActiveWorkers.load(std::memory_order_relaxed);
+  while (active > group.WorkerLimit.load(std::memory_order_relaxed)) {
+    if (group.ActiveWorkers.compare_exchange_weak(active, active - 1,
+                                                  std::memory_order_relaxed))
+      return true;
+  }
+  return false;
+}
+
+void ThreadPoolJobSystem::GoDormant(Worker *worker) noexcept {
+  // Same handshake as Park, against BeginBlocking instead of WakeWorkers.
+  worker->Dormant.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (m_Shutdown.load(std::memory_order_acquire) || IsSpareNeeded(worker)) {
+    if (worker->Dormant.exchange(false, std::memory_order_acq_rel))
+      return;
+  }
+  worker->Wakeup.acquire();
+}
+
+bool ThreadPoolJobSystem::IsSpareNeeded(const Worker *worker) const noexcept {
+  return worker->Home->BlockedWorkers.load(std::memory_order_relaxed) >
+         worker->SpareRank;
+}
+
+void ThreadPoolJobSystem::BeginBlocking(Group &group) noexcept {
+  const u32 blocked =
+      group.BlockedWorkers.fetch_add(1, std::memory_order_relaxed) + 1;
+  if (blocked > group.Spares.size())
+    return;
+
+  // Pairs with the fence in GoDormant.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  Worker *spare = group.Spares[blocked - 1];
+  if (spare->Dormant.load(std::memory_order_relaxed) &&
+      spare->Dormant.exchange(false, std::memory_order_acq_rel))
+    spare->Wakeup.release();
+}
+
+void ThreadPoolJobSystem::EndBlocking(Group &group) noexcept {
+  // The spare notices on its own once it runs out of work
+  group.BlockedWorkers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+Job *ThreadPoolJobSystem::GetNextReadyJob(Worker *self) noexcept {
+  // Nobody else can run a registered thread's jobs, so they go first.
+  if (!self) {
+    Job *job = nullptr;
+    if (JobThreadState *thread = CurrentJobThread();
+        thread && thread->Queue.Pop(job))
+      return job;
+  }
+
+  // Highest priority first. Workers stay inside their own group; other
+  // threads help with everything except Io, whose jobs may block them.
+  for (u32 level = PriorityCount; level-- > 0;) {
+    if (self) {
+      if (Job *job = TakeJob(*self->Home, level, self))
+        return job;
       continue;
     }
 
+    for (u32 index = GroupCount; index-- > 0;) {
+      if (index == GroupIndex(WorkerGroup::Io) || !m_Groups[index])
+        continue;
+      if (Job *job = TakeJob(*m_Groups[index], level, nullptr))
+        return job;
+    }
+  }
+  return nullptr;
+}
+
+Job *ThreadPoolJobSystem::TakeJob(Group &group, u32 priority,
+                                  Worker *self) noexcept {
+  // Prefer our own (cache-warm) work, then injected work, then stealing
+  // from a peer.
+  Job *job = nullptr;
+  if (self && self->Queues[priority].Pop(job))
+    return job;
+  if (group.InjectionQueues[priority]->Pop(job))
+    return job;
+  if (StealJob(group, priority, self, job)) {
+    WorkerTelemetry &telemetry = self ? self->Telemetry : *m_ExternalTelemetry;
+    telemetry.JobsStolen.fetch_add(1, std::memory_order_relaxed);
+    return job;
+  }
+  return nullptr;
+}
+
+bool ThreadPoolJobSystem::StealJob(Group &group, u32 priority, Worker *self,
+                                   Job *&out) noexcept {
+  const u32 workerCount = static_cast<u32>(group.Workers.size());
+  if (workerCount == 0)
+    return false;
+
+  // Random starting victim spreads thieves out instead of having them all
+  // hammer worker 0.
+  u32 &seed = self ? self->StealSeed : t_StealSeed;
+  auto tryVictims = [&](const std::vector<u32> &victims) {
+    const u32 count = static_cast<u32>(victims.size());
+    if (count == 0)
+      return false;
+    const u32 start = NextRandom(seed) % count;
+    for (u32 i = 0; i < count; ++i) {
+      Worker *victim = m_Workers[victims[(start + i) % count]].get();
+      if (victim->Queues[priority].Steal(out))
+        return true;
+    }
+    return false;
+  };
+
+  // Workers look on their own cache domain first; stolen work there is
+  // likely still warm.
+  if (self)
+    return tryVictims(self->NearVictims) || tryVictims(self->FarVictims);
+
+  const u32 start = NextRandom(seed) % workerCount;
+  for (u32 i = 0; i < workerCount; ++i) {
+    Worker *victim = group.Workers[(start + i) % workerCount];
+    if (victim->Queues[priority].Steal(out))
+      return true;
+  }
+  return false;
+}
+
+void ThreadPoolJobSystem::Enqueue(Job *job) noexcept {
+  if (job->Thread != 0) {
+    PushToThread(job);
+    return;
+  }
+
+  Group &group = *m_Groups[job->Group];
+  PushReady(job);
+  WakeWorkers(group, 1);
+}
+
+void ThreadPoolJobSystem::Dispatch(Job *job) noexcept {
+  if (ShouldRunInline(job))
+    RunInline(job);
+  else
+    Enqueue(job);
+}
+
+bool ThreadPoolJobSystem::ShouldRunInline(const Job *job) const noexcept {
+  if (job->Thread != 0 || Any(job->Flags & JobFlags::Blocking) ||
+      t_InlineDepth >= m_InlinePolicy.MaxDepth)
+    return false;
+
+  // Same rule as helping in Wait: workers stay in their group, other
+  // threads keep away from Io.
+  Group &group = *m_Groups[job->Group];
+  Worker *self = CurrentWorker();
+  if (self ? self->Home != &group
+           : job->Group == GroupIndex(WorkerGroup::Io))
+    return false;
+
+  const bool cheap =
+      m_InlinePolicy.CheapJobs && Any(job->Flags & JobFlags::Cheap);
+  if (!cheap && m_InlinePolicy.QueueDepth == 0)
+    return false;
+
+  // Running it now must not jump ahead of more urgent queued work.
+  const u32 priority = static_cast<u32>(job->Priority);
+  for (u32 level = priority + 1; level < PriorityCount; ++level) {
+    if (!group.InjectionQueues[level]->Empty() ||
+        (self && !self->Queues[level].Empty()))
+      return false;
+  }
+
+  if (cheap)
+    return true;
+  const u64 depth = self ? self->Queues[priority].SizeApprox()
+                         : group.InjectionQueues[priority]->SizeApprox();
+  return depth >= m_InlinePolicy.QueueDepth;
+}
+
+void ThreadPoolJobSystem::RunInline(Job *job) noexcept {
+  m_JobsRunInline.fetch_add(1, std::memory_order_relaxed);
+  ++t_InlineDepth;
+  Execute(job);
+  --t_InlineDepth;
+}
+
+void ThreadPoolJobSystem::PushReady(Job *job) noexcept {
+  const u32 priority = static_cast<u32>(job->Priority);
+  Group &group = *m_Groups[job->Group];
+
+  Worker *self = CurrentWorker();
+  if (!self || self->Home != &group || !self->Queues[priority].Push(job)) {
+    // The injection queue holds every live job, so a failed push only means
+    // a consumer has claimed the cell we need but not released it yet.
+    while (!group.InjectionQueues[priority]->Push(job))
+      CpuRelax();
+  }
+}
+
+void ThreadPoolJobSystem::PushToThread(Job *job) noexcept {
+  JobThreadState &thread = *m_JobThreads[job->Thread - 1];
+  while (!thread.Queue.Push(job))
+    CpuRelax();
+
+  // Pairs with the fence in BlockJobThread: either the thread sees the job
+  // before blocking, or we see it blocked and wake it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  Job *blockedOn = thread.BlockedOn.load(std::memory_order_relaxed);
+  if (blockedOn && thread.BlockedOn.compare_exchange_strong(
+                       blockedOn, nullptr, std::memory_order_acq_rel))
+    thread.Wakeup.release();
+}
+
+void ThreadPoolJobSystem::WakeWorkers(Group &group, u32 count) noexcept {
+  if (count == 0)
+    return;
+
+  // Pairs with the fence in Park: either the worker sees our job in its
+  // final check, or we see it parked and wake it.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (group.ParkedWorkers.load(std::memory_order_relaxed) == 0) {
+    RequestScaleCheck(group);
+    return;
+  }
+
+  // Wake specific workers, one per job, instead of broadcasting.
+  const u32 workerCount = static_cast<u32>(group.Workers.size());
+  const u32 start = group.WakeCursor.fetch_add(1, std::memory_order_relaxed);
+  for (u32 i = 0; i < workerCount && count > 0; ++i) {
+    Worker *worker = group.Workers[(start + i) % workerCount];
+    if (!worker->Parked.load(std::memory_order_relaxed) ||
+        !worker->Parked.exchange(false, std::memory_order_acq_rel))
+      continue;
+    group.ParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+    worker->Wakeup.release();
+    --count;
+  }
+  if (count > 0)
+    RequestScaleCheck(group);
+}
+
+void ThreadPoolJobSystem::RequestScaleCheck(Group &group) noexcept {
+  // Ready jobs found no idle worker. If that still holds ScaleUpWaitNs from
+  // now, the timer thread adds one; a check already pending covers this.
+  if (group.Elastic.empty() ||
+      group.ScaleCheckNs.load(std::memory_order_relaxed) != 0)
+    return;
+
+  u64 expected = 0;
+  const u64 dueNs = MonotonicTimeNs() + m_ScalingPolicy.ScaleUpWaitNs;
+  if (!group.ScaleCheckNs.compare_exchange_strong(expected, dueNs,
+                                                  std::memory_order_relaxed))
+    return;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    wake = dueNs < m_TimerWakeNs;
+  }
+  if (wake)
+    m_TimerWake.notify_one();
+}
+
+void ThreadPoolJobSystem::ScaleGroup(Group &group) noexcept {
+  GECKO_PROF_SCOPE(categories::Runtime, "ThreadPoolJobSystem::ScaleGroup");
+
+  // The quota is re-read here rather than polled, so an idle process never
+  // touches cgroupfs.
+  const u32 running =
+      group.ThreadCount + static_cast<u32>(group.Elastic.size());
+  u32 limit = running;
+  if (group.Index == 0 && m_ScalingPolicy.RespectCpuQuota) {
+    if (const u32 quota = DetectCpuQuota(); quota != 0)
+      limit = std::max(group.ThreadCount, std::min(running, quota));
+  }
+  group.WorkerLimit.store(limit, std::memory_order_relaxed);
+
+  bool started = false;
+  if (group.ParkedWorkers.load(std::memory_order_relaxed) == 0 &&
+      HasBacklog(group) &&
+      group.ActiveWorkers.load(std::memory_order_relaxed) < limit)
+    started = StartElasticWorker(group);
+
+  // Keep growing while the backlog lasts; otherwise the next submit that
+  // finds nobody idle arms a new check.
+  group.ScaleCheckNs.store(
+      started ? MonotonicTimeNs() + m_ScalingPolicy.ScaleUpWaitNs : 0,
+      std::memory_order_relaxed);
+}
+
+bool ThreadPoolJobSystem::StartElasticWorker(Group &group) noexcept {
+  for (Worker *worker : group.Elastic) {
+    if (!worker->Retired.load(std::memory_order_acquire))
+      continue;
+
+    // A retired thread has already left its loop, so this join is short.
+    if (worker->Thread.joinable())
+      worker->Thread.join();
+    worker->Retired.store(false, std::memory_order_relaxed);
+    group.ActiveWorkers.fetch_add(1, std::memory_order_relaxed);
     try {
-      GECKO_PROF_SCOPE(categories::Runtime, "Job::Execute");
-      GECKO_PROF_COUNTER(categories::Runtime, "jobs_processed", 1);
+      worker->Thread = std::thread(&ThreadPoolJobSystem::WorkerThreadFunction,
+                                   this, worker);
+    } catch (...) {
+      group.ActiveWorkers.fetch_sub(1, std::memory_order_relaxed);
+      worker->Retired.store(true, std::memory_order_relaxed);
+      GECKO_WARN(categories::Runtime, "Failed to start elastic worker %u",
+                 worker->Index);
+      return false;
+    }
+    m_WorkersStarted.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  return false;
+}
+
+void ThreadPoolJobSystem::WakeAllGroups(bool onlyWithWork) noexcept {
+  for (auto &group : m_Groups) {
+    if (group && (!onlyWithWork || HasQueuedJobs(*group)))
+      WakeWorkers(*group, static_cast<u32>(group->Workers.size()));
+  }
+}
+
+bool ThreadPoolJobSystem::HasBacklog(const Group &group) const noexcept {
+  if (HasQueuedJobs(group))
+    return true;
+  // Busy workers keep the jobs they spawn in their own deques.
+  for (const Worker *worker : group.Workers) {
+    for (const auto &queue : worker->Queues) {
+      if (!queue.Empty())
+        return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPoolJobSystem::HasQueuedJobs(const Group &group) const noexcept {
+  for (const auto &queue : group.InjectionQueues) {
+    if (!queue->Empty())
+      return true;
+  }
 
+  for (const Worker *worker : group.Workers) {
+    for (const auto &queue : worker->Queues) {
+      if (!queue.Empty())
+        return true;
+    }
+  }
+  return false;
+}
+
+void ThreadPoolJobSystem::Execute(Job *job) noexcept {
+  // Cancelled jobs are dropped when they reach the front of a queue, which
+  // is cheaper than pulling them out of the lock-free queues early.
+  if (IsCancelled(job)) {
+    m_JobsCancelled.fetch_add(1, std::memory_order_relaxed);
+    CompleteJob(job, true);
+    return;
+  }
+
+  // Only a worker blocking takes capacity away from its group
+  Worker *self = CurrentWorker();
+  Group *blockedGroup =
+      self && Any(job->Flags & JobFlags::Blocking) ? self->Home : nullptr;
+  if (blockedGroup)
+    BeginBlocking(*blockedGroup);
+
+  const u64 startNs = MonotonicTimeNs();
+  try {
+    GECKO_PROF_SCOPE(categories::Runtime, "Job::Execute");
+
+    if (job->Function)
       job->Function();
-      job->Completed.store(true, std::memory_order_release);
 
+  } catch (...) {
+    GECKO_ERROR(categories::Runtime, "Job %llu threw an exception on thread %u",
+                static_cast<unsigned long long>(job->Handle.Id),
+                ThisThreadId());
+  }
+  const u64 endNs = MonotonicTimeNs();
+  if (blockedGroup)
+    EndBlocking(*blockedGroup);
+
+  RecordJob(self, job, startNs, endNs);
+  CompleteJob(job, false);
+
+  if (m_TelemetryIntervalNs != 0 &&
+      endNs >= m_NextTelemetryNs.load(std::memory_order_relaxed))
+    EmitTelemetry(endNs);
+}
+
+void ThreadPoolJobSystem::RecordJob(Worker *self, const Job *job, u64 startNs,
+                                    u64 endNs) noexcept {
+  const u32 priority = static_cast<u32>(job->Priority);
+  const u64 waitNs = startNs > job->SubmitNs ? startNs - job->SubmitNs : 0;
+  const u64 runNs = endNs - startNs;
+
+  // A worker's block is only written by that worker; the external block is
+  // shared by every helping thread.
+  if (self)
+    self->Telemetry.RecordJob<false>(priority, job->Cat, waitNs, runNs);
+  else
+    m_ExternalTelemetry->RecordJob<true>(priority, job->Cat, waitNs, runNs);
+}
+
+bool ThreadPoolJobSystem::IsCancelled(const Job *job) const noexcept {
+  return job->DependencyCancelled.load(std::memory_order_relaxed) ||
+         (job->Cancellation && job->Cancellation->IsCancelled());
+}
+
+void ThreadPoolJobSystem::CompleteJob(Job *job, bool cancelled) noexcept {
+  // Moving to the next generation under the successor lock is what marks the
+  // job complete: late dependents and IsComplete both see the new value, and
+  // we take ownership of everything that registered before it.
+  LockSuccessors(job);
+  JobDependencyEdge *edge = job->Successors;
+  job->Successors = nullptr;
+  job->Generation.fetch_add(1, std::memory_order_release);
+  UnlockSuccessors(job);
+
+  // Pairs with the fence in BlockUntilComplete.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (job->Waiters.load(std::memory_order_relaxed) > 0) {
+    job->Generation.notify_all();
+    WakeJobThreads(job);
+    WakeBlockedWorkers(job);
+  }
+
+  // Release everything that was waiting. Only successors whose last
+  // dependency this was get queued; a cancelled job passes the cancellation
+  // on, so they are dropped in turn when dequeued.
+  while (edge) {
+    // The edge belongs to the successor, which may run and recycle its slot
+    // as soon as we release it.
+    JobDependencyEdge *next = edge->Next;
+    Job *successor = edge->Successor;
+    if (cancelled)
+      successor->DependencyCancelled.store(true, std::memory_order_relaxed);
+    if (successor->PendingDependencies.fetch_sub(
+            1, std::memory_order_acq_rel) == 1)
+      Enqueue(successor);
+    edge = next;
+  }
+
+  ReleaseJob(job);
+}
+
+bool ThreadPoolJobSystem::AddSuccessor(JobHandle dependency, Job *successor,
+                                       JobDependencyEdge *edge) noexcept {
+  u32 generation = 0;
+  Job *job = ResolveHandle(dependency, generation);
+  if (!job)
+    return false;
+
+  bool added = false;
+  LockSuccessors(job);
+  if (job->Generation.load(std::memory_order_relaxed) == generation) {
+    successor->PendingDependencies.fetch_add(1, std::memory_order_relaxed);
+    edge->Successor = successor;
+    edge->Next = job->Successors;
+    job->Successors = edge;
+    added = true;
+  }
+  UnlockSuccessors(job);
+  return added;
+}
+
+Job *ThreadPoolJobSystem::ResolveHandle(JobHandle handle,
+                                        u32 &generation) const noexcept {
+  const u32 indexPlusOne = static_cast<u32>(handle.Id);
+  if (indexPlusOne == 0 || indexPlusOne > m_JobCapacity || !m_Jobs)
+    return nullptr;
+
+  generation = static_cast<u32>(handle.Id >> 32);
+  return &m_Jobs[indexPlusOne - 1];
+}
+
+Job *ThreadPoolJobSystem::AcquireJob() noexcept {
+  bool counted = false;
+  for (;;) {
+    u64 head = m_FreeJobs.load(std::memory_order_acquire);
+    const u32 indexPlusOne = static_cast<u32>(head);
+    if (indexPlusOne != 0) {
+      Job *job = &m_Jobs[indexPlusOne - 1];
+      const u32 next = job->NextFree.load(std::memory_order_relaxed);
+      if (m_FreeJobs.compare_exchange_weak(
+              head, PackFreeHead((head >> 32) + 1, next),
+              std::memory_order_acquire, std::memory_order_relaxed)) {
+        job->PendingDependencies.store(1, std::memory_order_relaxed);
+        return job;
+      }
+      continue;
+    }
+
+    // Pool exhausted: help drain it rather than failing the submit.
+    if (m_Shutdown.load(std::memory_order_acquire))
+      return nullptr;
+    if (!counted) {
+      m_PoolExhaustedWaits.fetch_add(1, std::memory_order_relaxed);
+      counted = true;
+      // A batch may have queued work without waking anyone yet.
+      WakeAllGroups(true);
+    }
+    if (Job *ready = GetNextReadyJob(CurrentWorker()))
+      Execute(ready);
+    else
+      YieldThread();
+  }
+}
+
+void ThreadPoolJobSystem::ReleaseJob(Job *job) noexcept {
+  // Drop captured state now rather than when the slot is next reused.
+  job->Function = nullptr;
+  FreeOverflowEdges(job);
+
+  // A result keeps the slot until its future lets go of it as well.
+  if (job->Result &&
+      job->ResultReferences.fetch_sub(1, std::memory_order_acq_rel) != 1)
+    return;
+  RecycleJob(job);
+}
+
+void ThreadPoolJobSystem::RecycleJob(Job *job) noexcept {
+  if (job->Result) {
+    job->DestroyResult(job->Result);
+    job->Result = nullptr;
+  }
+
+  const u32 indexPlusOne = static_cast<u32>(job - m_Jobs) + 1;
+  u64 head = m_FreeJobs.load(std::memory_order_relaxed);
+  do {
+    job->NextFree.store(static_cast<u32>(head), std::memory_order_relaxed);
+  } while (!m_FreeJobs.compare_exchange_weak(
+      head, PackFreeHead((head >> 32) + 1, indexPlusOne),
+      std::memory_order_release, std::memory_order_relaxed));
+}
+
+ThreadPoolJobSystem::Worker *
+ThreadPoolJobSystem::CurrentWorker() const noexcept {
+  auto *worker =
+      static_cast<Worker *>(const_cast<void *>(t_CurrentWorker));
+  return (worker && worker->Owner == this) ? worker : nullptr;
+}
+
+void ThreadPoolJobSystem::SetJobCapacity(u32 capacity) noexcept {
+  GECKO_ASSERT(!m_Initialized && "Job capacity must be set before Init");
+  u32 rounded = 1;
+  while (rounded < capacity && rounded < (1u << 31))
+    rounded <<= 1;
+  m_JobCapacity = rounded;
+}
+
+JobSystemStats ThreadPoolJobSystem::Stats() const noexcept {
+  JobSystemStats stats;
+  stats.HeapAllocations = m_HeapAllocations.load(std::memory_order_relaxed);
+  stats.PoolExhaustedWaits =
+      m_PoolExhaustedWaits.load(std::memory_order_relaxed);
+  stats.WorkerParks = m_WorkerParks.load(std::memory_order_relaxed);
+  stats.JobsCancelled = m_JobsCancelled.load(std::memory_order_relaxed);
+  stats.WorkersStarted = m_WorkersStarted.load(std::memory_order_relaxed);
+  stats.WorkersRetired = m_WorkersRetired.load(std::memory_order_relaxed);
+  stats.JobsRunInline = m_JobsRunInline.load(std::memory_order_relaxed);
+  return stats;
+}
+
+JobSystemTelemetry ThreadPoolJobSystem::Telemetry() const noexcept {
+  JobSystemTelemetry telemetry;
+  if (m_Initialized)
+    CollectTelemetry(telemetry);
+  return telemetry;
+}
+
+void ThreadPoolJobSystem::CollectTelemetry(
+    JobSystemTelemetry &out) const noexcept {
+  out.UptimeNs = MonotonicTimeNs() - m_InitNs;
+  out.Workers.clear();
+  out.ByCategory.clear();
+  for (JobLatencyStats &latency : out.ByPriority)
+    latency = JobLatencyStats{};
+
+  auto collect = [&out](const WorkerTelemetry &telemetry, WorkerStats &stats) {
+    stats.JobsExecuted =
+        telemetry.JobsExecuted.load(std::memory_order_relaxed);
+    stats.JobsStolen = telemetry.JobsStolen.load(std::memory_order_relaxed);
+    stats.BusyNs = telemetry.BusyNs.load(std::memory_order_relaxed);
+
+    for (u32 p = 0; p < PriorityCount; ++p) {
+      telemetry.ByPriority[p].Wait.AddTo(out.ByPriority[p].Wait);
+      telemetry.ByPriority[p].Run.AddTo(out.ByPriority[p].Run);
+    }
+
+    for (const auto &slot : telemetry.Categories) {
+      const u32 id = slot.Id.load(std::memory_order_acquire);
+      if (id == 0 || id == WorkerTelemetry::ClaimingSlot)
+        continue;
+
+      auto it = std::find_if(out.ByCategory.begin(), out.ByCategory.end(),
+                             [id](const CategoryLatencyStats &entry) {
+                               return entry.Cat.Id == id;
+                             });
+      if (it == out.ByCategory.end()) {
+        try {
+          out.ByCategory.push_back(CategoryLatencyStats{});
+        } catch (...) {
+          continue;
+        }
+        it = out.ByCategory.end() - 1;
+        it->Cat = Category{id, slot.Name};
+      }
+      slot.Latency.Wait.AddTo(it->Latency.Wait);
+      slot.Latency.Run.AddTo(it->Latency.Run);
+    }
+  };
+
+  for (const auto &worker : m_Workers) {
+    WorkerStats stats;
+    collect(worker->Telemetry, stats);
+    try {
+      out.Workers.push_back(stats);
     } catch (...) {
-      GECKO_ERROR(categories::Runtime,
-                  "Job %llu threw an exception on worker thread %u",
-                  job->Handle.Id, threadId);
-      job->Completed.store(true, std::memory_order_release);
     }
+  }
+  collect(*m_ExternalTelemetry, out.External);
+
+  for (u32 p = 0; p < PriorityCount; ++p) {
+    u64 depth = 0;
+    for (const auto &group : m_Groups) {
+      if (group)
+        depth += group->InjectionQueues[p]->SizeApprox();
+    }
+    for (const auto &worker : m_Workers)
+      depth += worker->Queues[p].SizeApprox();
+    out.QueueDepth[p] = depth;
+  }
+}
 
-    {
-      std::lock_guard<std::mutex> lock(m_Mutex);
-      m_ActiveJobs.erase(job->Handle.Id);
+void ThreadPoolJobSystem::EmitTelemetry(u64 nowNs) noexcept {
+  // One emitter at a time; everyone else just carries on.
+  if (m_EmittingTelemetry.test_and_set(std::memory_order_acquire))
+    return;
+  if (nowNs < m_NextTelemetryNs.load(std::memory_order_relaxed)) {
+    m_EmittingTelemetry.clear(std::memory_order_release);
+    return;
+  }
+  m_NextTelemetryNs.store(nowNs + m_TelemetryIntervalNs,
+                          std::memory_order_relaxed);
+
+  GECKO_PROF_SCOPE(categories::Runtime, "JobSystem::EmitTelemetry");
+  JobSystemTelemetry &current = *m_TelemetryCurrent;
+  const JobSystemTelemetry &previous = *m_TelemetryPrevious;
+  CollectTelemetry(current);
+
+  const u64 elapsedNs = current.UptimeNs - previous.UptimeNs;
+  u64 executed = current.External.JobsExecuted -
+                 previous.External.JobsExecuted;
+  u64 stolen = current.External.JobsStolen - previous.External.JobsStolen;
+  for (size_t i = 0; i < current.Workers.size(); ++i) {
+    const WorkerStats &now = current.Workers[i];
+    const WorkerStats before =
+        i < previous.Workers.size() ? previous.Workers[i] : WorkerStats{};
+    executed += now.JobsExecuted - before.JobsExecuted;
+    stolen += now.JobsStolen - before.JobsStolen;
+    if (elapsedNs > 0) {
+      GECKO_PROF_COUNTER(categories::Runtime,
+                         m_Workers[i]->UtilizationCounter,
+                         (now.BusyNs - before.BusyNs) * 100 / elapsedNs);
     }
+  }
+  GECKO_PROF_COUNTER(categories::Runtime, "jobs_executed", executed);
+  GECKO_PROF_COUNTER(categories::Runtime, "jobs_stolen", stolen);
+
+  // Percentiles over this interval only
+  LatencyHistogram interval;
+  for (u32 priority = 0; priority < PriorityCount; ++priority) {
+    GECKO_PROF_COUNTER(categories::Runtime, QueueDepthCounters[priority],
+                       current.QueueDepth[priority]);
+
+    interval = current.ByPriority[priority].Wait;
+    interval.Subtract(previous.ByPriority[priority].Wait);
+    if (interval.Count == 0)
+      continue;
+    GECKO_PROF_COUNTER(categories::Runtime, WaitP50Counters[priority],
+                       interval.Percentile(50.0));
+    GECKO_PROF_COUNTER(categories::Runtime, WaitP99Counters[priority],
+                       interval.Percentile(99.0));
 
-    m_JobCompleted.notify_all();
+    interval = current.ByPriority[priority].Run;
+    interval.Subtract(previous.ByPriority[priority].Run);
+    GECKO_PROF_COUNTER(categories::Runtime, RunP99Counters[priority],
+                       interval.Percentile(99.0));
   }
 
-  GECKO_TRACE(categories::Runtime, "Worker thread %u exiting", threadId);
+  // Per-category series share names and are told apart by their category
+  for (const CategoryLatencyStats &entry : current.ByCategory) {
+    auto before = std::find_if(previous.ByCategory.begin(),
+                               previous.ByCategory.end(),
+                               [&entry](const CategoryLatencyStats &other) {
+                                 return other.Cat.Id == entry.Cat.Id;
+                               });
+
+    interval = entry.Latency.Wait;
+    if (before != previous.ByCategory.end())
+      interval.Subtract(before->Latency.Wait);
+    if (interval.Count == 0)
+      continue;
+    GECKO_PROF_COUNTER(entry.Cat, "job_wait_p99_ns", interval.Percentile(99.0));
+
+    interval = entry.Latency.Run;
+    if (before != previous.ByCategory.end())
+      interval.Subtract(before->Latency.Run);
+    GECKO_PROF_COUNTER(entry.Cat, "job_run_p99_ns", interval.Percentile(99.0));
+  }
+
+  std::swap(m_TelemetryCurrent, m_TelemetryPrevious);
+  m_EmittingTelemetry.clear(std::memory_order_release);
 }
 
-std::shared_ptr<Job> ThreadPoolJobSystem::GetNextReadyJob() noexcept {
-  std::lock_guard<std::mutex> lock(m_Mutex);
+void ThreadPoolJobSystem::BlockUntilComplete(Job *job,
+                                             u32 generation) noexcept {
+  // Registering before re-checking the generation pairs with the fence in
+  // CompleteJob: either it sees us and notifies, or we see the new value.
+  job->Waiters.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  job->Generation.wait(generation, std::memory_order_acquire);
+  job->Waiters.fetch_sub(1, std::memory_order_relaxed);
+}
 
-  if (m_JobQueue.empty())
+void ThreadPoolJobSystem::BlockWorker(Worker &worker, Job *job,
+                                      u32 generation) noexcept {
+  // Park's handshake, plus the job: WakeWorkers and CompleteJob both claim
+  // the wake-up through Parked, so exactly one of them releases Wakeup.
+  Group &group = *worker.Home;
+  worker.BlockedOn.store(job, std::memory_order_relaxed);
+  job->Waiters.fetch_add(1, std::memory_order_relaxed);
+  worker.Parked.store(true, std::memory_order_relaxed);
+  group.ParkedWorkers.fetch_add(1, std::memory_order_relaxed);
+  // Pairs with the fences in WakeWorkers and CompleteJob.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  if (m_Shutdown.load(std::memory_order_acquire) || HasQueuedJobs(group) ||
+      job->Generation.load(std::memory_order_acquire) != generation) {
+    if (worker.Parked.exchange(false, std::memory_order_acq_rel))
+      group.ParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+    else
+      worker.Wakeup.acquire(); // Take the release the waker owes
+  } else {
+    GECKO_PROF_SCOPE(categories::Runtime, "WorkerBlocked");
+    worker.Wakeup.acquire();
+  }
+
+  worker.BlockedOn.store(nullptr, std::memory_order_relaxed);
+  job->Waiters.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void ThreadPoolJobSystem::WakeBlockedWorkers(Job *job) noexcept {
+  // A stale match only wakes an idle worker early; it parks again.
+  for (auto &worker : m_Workers) {
+    if (worker->BlockedOn.load(std::memory_order_relaxed) != job ||
+        !worker->Parked.load(std::memory_order_relaxed) ||
+        !worker->Parked.exchange(false, std::memory_order_acq_rel))
+      continue;
+    worker->Home->ParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+    worker->Wakeup.release();
+  }
+}
+
+ThreadPoolJobSystem::JobThreadState *
+ThreadPoolJobSystem::CurrentJobThread() const noexcept {
+  const u32 count = m_JobThreadCount.load(std::memory_order_acquire);
+  if (count == 0)
     return nullptr;
 
-  // Find a job whose dependencies are complete
-  std::priority_queue<std::shared_ptr<Job>, std::vector<std::shared_ptr<Job>>,
-                      JobCompare>
-      tempQueue;
-  std::shared_ptr<Job> candidateJob = nullptr;
+  const std::thread::id id = std::this_thread::get_id();
+  for (u32 i = 0; i < count; ++i) {
+    if (m_JobThreads[i]->Owner == id)
+      return m_JobThreads[i].get();
+  }
+  return nullptr;
+}
 
-  while (!m_JobQueue.empty() && !candidateJob) {
-    auto job = m_JobQueue.top();
-    m_JobQueue.pop();
+void ThreadPoolJobSystem::BlockJobThread(JobThreadState &thread, Job *job,
+                                         u32 generation) noexcept {
+  // Like BlockUntilComplete, except that a job pushed to this thread wakes
+  // it too: what we wait on may depend on it.
+  thread.BlockedOn.store(job, std::memory_order_relaxed);
+  job->Waiters.fetch_add(1, std::memory_order_seq_cst);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
 
-    if (AreJobDependenciesComplete(job)) {
-      candidateJob = job;
-    } else {
-      tempQueue.push(job);
-    }
+  if (thread.Queue.Empty() &&
+      job->Generation.load(std::memory_order_acquire) == generation) {
+    thread.Wakeup.acquire();
+  } else {
+    // If a waker already claimed us, take the release it owes.
+    Job *expected = job;
+    if (!thread.BlockedOn.compare_exchange_strong(expected, nullptr,
+                                                  std::memory_order_acq_rel))
+      thread.Wakeup.acquire();
   }
+  job->Waiters.fetch_sub(1, std::memory_order_relaxed);
+}
 
-  // Put back jobs that weren't ready
-  while (!tempQueue.empty()) {
-    m_JobQueue.push(tempQueue.top());
-    tempQueue.pop();
+void ThreadPoolJobSystem::WakeJobThreads(Job *job) noexcept {
+  const u32 count = m_JobThreadCount.load(std::memory_order_acquire);
+  for (u32 i = 0; i < count; ++i) {
+    JobThreadState &thread = *m_JobThreads[i];
+    Job *expected = job;
+    if (thread.BlockedOn.load(std::memory_order_relaxed) == job &&
+        thread.BlockedOn.compare_exchange_strong(expected, nullptr,
+                                                 std::memory_order_acq_rel))
+      thread.Wakeup.release();
   }
+}
 
-  return candidateJob;
+JobHandle ThreadPoolJobSystem::MakeHandle(const Job *job) const noexcept {
+  // Generation in the high half, slot index + 1 below so 0 stays invalid.
+  const u64 generation = job->Generation.load(std::memory_order_relaxed);
+  const u64 indexPlusOne = static_cast<u64>(job - m_Jobs) + 1;
+  return JobHandle{(generation << 32) | indexPlusOne};
 }
 
-bool ThreadPoolJobSystem::AreJobDependenciesComplete(
-    const std::shared_ptr<Job> &job) noexcept {
-  for (const auto &dependency : job->Dependencies) {
-    auto it = m_ActiveJobs.find(dependency.Id);
-    if (it != m_ActiveJobs.end() &&
-        !it->second->Completed.load(std::memory_order_acquire)) {
-      return false;
+void ThreadPoolJobSystem::TimerThreadFunction() noexcept {
+  SetCurrentThreadName("gecko-timer");
+
+  std::unique_lock<std::mutex> lock(m_TimerMutex);
+  while (!m_TimerStop) {
+    m_TimerWakeNs = 0;
+    const u64 nowNs = MonotonicTimeNs();
+    if (TimerWheelEntry *expired = m_TimerWheel->Advance(nowNs)) {
+      lock.unlock();
+      ReleaseTimers(expired);
+      lock.lock();
+      continue;
+    }
+
+    // Scale checks ride along with the wheel's deadlines.
+    u64 wakeNs = m_TimerWheel->NextDeadlineNs();
+    Group *due = nullptr;
+    for (auto &group : m_Groups) {
+      const u64 checkNs =
+          group ? group->ScaleCheckNs.load(std::memory_order_relaxed) : 0;
+      if (checkNs != 0 && checkNs <= nowNs)
+        due = group.get();
+      else if (checkNs != 0)
+        wakeNs = std::min(wakeNs, checkNs);
+    }
+    if (due) {
+      lock.unlock();
+      ScaleGroup(*due);
+      lock.lock();
+      continue;
+    }
+
+    // MonotonicTimeNs counts steady_clock, so deadlines map onto it directly.
+    m_TimerWakeNs = wakeNs;
+    if (m_TimerWakeNs == TimerWheel::NoDeadline) {
+      m_TimerWake.wait(lock);
+    } else {
+      const std::chrono::steady_clock::time_point deadline(
+          std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+              std::chrono::nanoseconds(m_TimerWakeNs)));
+      m_TimerWake.wait_until(lock, deadline);
     }
   }
+}
+
+bool ThreadPoolJobSystem::ArmTimer(Job *job, u64 deadlineNs) noexcept {
+  if (deadlineNs <= MonotonicTimeNs())
+    return false;
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    job->Timer.DeadlineNs = deadlineNs;
+    m_TimerWheel->Insert(&job->Timer);
+    // Only an earlier deadline than the one slept on needs a wake-up; an
+    // awake timer thread looks at the wheel again before sleeping.
+    wake = deadlineNs < m_TimerWakeNs;
+  }
+  if (wake)
+    m_TimerWake.notify_one();
   return true;
 }
 
-JobHandle ThreadPoolJobSystem::GenerateJobHandle() noexcept {
-  return JobHandle{m_NextJobId.fetch_add(1, std::memory_order_relaxed)};
+void ThreadPoolJobSystem::ReleaseTimers(TimerWheelEntry *expired) noexcept {
+  u32 readyCount[GroupCount]{};
+  while (expired) {
+    // Read the link first: a released job may run and be reused at once.
+    TimerWheelEntry *next = expired->Next;
+    Job *job = static_cast<Job *>(expired->Context);
+    if (ReleaseSubmitReference(job)) {
+      if (job->Thread != 0) {
+        PushToThread(job);
+      } else {
+        ++readyCount[job->Group];
+        PushReady(job);
+      }
+    }
+    expired = next;
+  }
+
+  for (u32 index = 0; index < GroupCount; ++index) {
+    if (readyCount[index] > 0)
+      WakeWorkers(*m_Groups[index], readyCount[index]);
+  }
+}
+
+void ThreadPoolJobSystem::RunPeriodic(PeriodicState &state) noexcept {
+  state.Function();
+
+  // Fixed rate: the next run is due a whole number of periods after the
+  // last deadline, skipping any this run overran.
+  const u64 now = MonotonicTimeNs();
+  u64 next = state.DeadlineNs + state.PeriodNs;
+  if (next <= now)
+    next += ((now - next) / state.PeriodNs + 1) * state.PeriodNs;
+  state.DeadlineNs = next;
+  SchedulePeriodic(state);
+}
+
+void ThreadPoolJobSystem::SchedulePeriodic(PeriodicState &state) noexcept {
+  JobDesc desc;
+  desc.Function = [this, &state]() { RunPeriodic(state); };
+  desc.Priority = state.Priority;
+  desc.Cat = state.Cat;
+  desc.Group = state.Group;
+  desc.Flags = state.Flags;
+  desc.Thread = state.Thread;
+  // Outside the lock: this may wait for a free slot.
+  Job *job = PrepareJob(desc);
+
+  bool wake = false;
+  {
+    std::lock_guard<std::mutex> lock(m_TimerMutex);
+    if (job && !state.Cancelled) {
+      job->Timer.DeadlineNs = state.DeadlineNs;
+      m_TimerWheel->Insert(&job->Timer);
+      state.Current = job->Handle;
+      wake = state.DeadlineNs < m_TimerWakeNs;
+      job = nullptr;
+    }
+  }
+  if (wake)
+    m_TimerWake.notify_one();
+
+  // Cancelled while this run was in flight; the next one never happens.
+  if (job)
+    CompleteJob(job, true);
 }
 
 } // namespace gecko::runtime
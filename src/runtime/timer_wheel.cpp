@@ -0,0 +1,171 @@
+#include "gecko/runtime/timer_wheel.h"
+
+#include <algorithm>
+#include <bit>
+
+#include "gecko/core/assert.h"
+
+namespace gecko::runtime {
+
+namespace {
+
+constexpr u64 TickNs = u64{1} << TimerWheel::TickShift;
+constexpr u64 SlotMask = TimerWheel::SlotCount - 1;
+// Ticks covered by the whole wheel; the overflow list is revisited once per
+// span.
+constexpr u64 WheelSpan = u64{1}
+                          << (TimerWheel::SlotBits * TimerWheel::LevelCount);
+
+// First tick starting at or after `deadlineNs`.
+constexpr u64 DeadlineTick(u64 deadlineNs) noexcept {
+  if (deadlineNs > TimerWheel::NoDeadline - (TickNs - 1))
+    return TimerWheel::NoDeadline >> TimerWheel::TickShift;
+  return (deadlineNs + TickNs - 1) >> TimerWheel::TickShift;
+}
+
+} // namespace
+
+TimerWheel::TimerWheel(u64 nowNs) noexcept
+    : m_CurrentTick(nowNs >> TickShift) {}
+
+void TimerWheel::Insert(TimerWheelEntry *entry) noexcept {
+  GECKO_ASSERT(entry && !entry->IsLinked() && "Timer entry already linked");
+  Place(entry);
+  ++m_Count;
+}
+
+void TimerWheel::Remove(TimerWheelEntry *entry) noexcept {
+  if (!entry->IsLinked())
+    return;
+
+  *entry->Prev = entry->Next;
+  if (entry->Next)
+    entry->Next->Prev = entry->Prev;
+  if (entry->Bucket != OverflowBucket && !m_Buckets[entry->Bucket]) {
+    m_Occupied[entry->Bucket / SlotCount] &=
+        ~(u64{1} << (entry->Bucket % SlotCount));
+  }
+  entry->Next = nullptr;
+  entry->Prev = nullptr;
+  --m_Count;
+}
+
+TimerWheelEntry *TimerWheel::Advance(u64 nowNs) noexcept {
+  const u64 target = nowNs >> TickShift;
+  TimerWheelEntry *expired = nullptr;
+
+  // Jump from one occupied slot to the next instead of stepping every tick,
+  // so a long sleep costs as much as the work actually due.
+  for (;;) {
+    const u64 tick = NextEventTick();
+    if (tick == NoDeadline || tick > target)
+      break;
+    m_CurrentTick = tick;
+    ProcessTick(tick, expired);
+    m_CurrentTick = tick + 1;
+  }
+
+  // Nothing is due before the next event, so skipping ahead keeps every
+  // level's slots relative to the same block.
+  if (m_CurrentTick <= target)
+    m_CurrentTick = target + 1;
+  return expired;
+}
+
+u64 TimerWheel::NextDeadlineNs() const noexcept {
+  const u64 tick = NextEventTick();
+  return tick == NoDeadline ? NoDeadline : tick << TickShift;
+}
+
+void TimerWheel::Place(TimerWheelEntry *entry) noexcept {
+  const u64 tick = std::max(DeadlineTick(entry->DeadlineNs), m_CurrentTick);
+
+  // An entry goes on the lowest level whose current block contains its tick.
+  for (u32 level = 0; level < LevelCount; ++level) {
+    const u32 blockShift = SlotBits * (level + 1);
+    if ((tick >> blockShift) == (m_CurrentTick >> blockShift)) {
+      const u64 slot = (tick >> (SlotBits * level)) & SlotMask;
+      Link(entry, level * SlotCount + static_cast<u32>(slot));
+      return;
+    }
+  }
+  Link(entry, OverflowBucket);
+}
+
+void TimerWheel::Link(TimerWheelEntry *entry, u32 bucket) noexcept {
+  TimerWheelEntry *&head = m_Buckets[bucket];
+  entry->Bucket = bucket;
+  entry->Next = head;
+  if (head)
+    head->Prev = &entry->Next;
+  entry->Prev = &head;
+  head = entry;
+  if (bucket != OverflowBucket)
+    m_Occupied[bucket / SlotCount] |= u64{1} << (bucket % SlotCount);
+}
+
+TimerWheelEntry *TimerWheel::TakeBucket(u32 bucket) noexcept {
+  TimerWheelEntry *head = m_Buckets[bucket];
+  m_Buckets[bucket] = nullptr;
+  if (bucket != OverflowBucket)
+    m_Occupied[bucket / SlotCount] &= ~(u64{1} << (bucket % SlotCount));
+  return head;
+}
+
+void TimerWheel::ProcessTick(u64 tick, TimerWheelEntry *&expired) noexcept {
+  auto replace = [this](TimerWheelEntry *entry) {
+    while (entry) {
+      TimerWheelEntry *next = entry->Next;
+      entry->Prev = nullptr;
+      Place(entry);
+      entry = next;
+    }
+  };
+
+  // Top down, so an entry can move several levels in one tick and still
+  // expire in it.
+  if ((tick & (WheelSpan - 1)) == 0)
+    replace(TakeBucket(OverflowBucket));
+  for (u32 level = LevelCount - 1; level > 0; --level) {
+    const u32 shift = SlotBits * level;
+    if ((tick & ((u64{1} << shift) - 1)) != 0)
+      continue;
+    const u64 slot = (tick >> shift) & SlotMask;
+    replace(TakeBucket(level * SlotCount + static_cast<u32>(slot)));
+  }
+
+  TimerWheelEntry *entry = TakeBucket(static_cast<u32>(tick & SlotMask));
+  while (entry) {
+    TimerWheelEntry *next = entry->Next;
+    entry->Prev = nullptr;
+    entry->Next = expired;
+    expired = entry;
+    --m_Count;
+    entry = next;
+  }
+}
+
+u64 TimerWheel::NextEventTick() const noexcept {
+  if (m_Count == 0)
+    return NoDeadline;
+
+  // Slots behind the current one on each level are always empty, so the
+  // first occupied slot at or after it is that level's next event.
+  u64 next = NoDeadline;
+  for (u32 level = 0; level < LevelCount; ++level) {
+    const u32 shift = SlotBits * level;
+    const u64 current = (m_CurrentTick >> shift) & SlotMask;
+    const u64 pending = m_Occupied[level] & (~u64{0} << current);
+    if (!pending)
+      continue;
+    const u64 block = (m_CurrentTick >> (shift + SlotBits))
+                      << (shift + SlotBits);
+    const u64 slot = static_cast<u64>(std::countr_zero(pending));
+    next = std::min(next, block | (slot << shift));
+  }
+  if (m_Buckets[OverflowBucket])
+    next = std::min(next, (m_CurrentTick + WheelSpan - 1) & ~(WheelSpan - 1));
+  return next;
+}
+
+} // namespace gecko::runtime
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+
+#include "gecko/core/assert.h"
+#include "gecko/core/types.h"
+
+namespace gecko::runtime {
+
+// Fixed-capacity Chase-Lev deque. Orderings follow Le et al., "Correct and
+// Efficient Work-Stealing for Weak Memory Models", with the standalone fences
+// folded into seq_cst accesses so sanitizers can follow them. The owning worker
+// pushes and pops at the bottom (LIFO, cache-warm); any other thread steals
+// from the top (FIFO). A failed Push means the deque is full and the caller
+// should fall back to a shared queue.
+template <typename T> class WorkStealingDeque {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "WorkStealingDeque stores items by value in atomics");
+
+public:
+  explicit WorkStealingDeque(u32 capacityPow2 = 1024)
+      : m_Buffer(std::make_unique<std::atomic<T>[]>(capacityPow2)),
+        m_Mask(static_cast<i64>(capacityPow2) - 1) {
+    GECKO_ASSERT(capacityPow2 > 0 &&
+                 (capacityPow2 & (capacityPow2 - 1)) == 0 &&
+                 "Deque capacity must be a power of 2");
+  }
+
+  WorkStealingDeque(const WorkStealingDeque &) = delete;
+  WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+
+  // Owner only.
+  bool Push(T item) noexcept {
+    i64 bottom = m_Bottom.load(std::memory_order_relaxed);
+    i64 top = m_Top.load(std::memory_order_acquire);
+    if (bottom - top > m_Mask)
+      return false;
+
+    m_Buffer[bottom & m_Mask].store(item, std::memory_order_relaxed);
+    m_Bottom.store(bottom + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Owner only.
+  bool Pop(T &out) noexcept {
+    i64 bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+    m_Bottom.store(bottom, std::memory_order_seq_cst);
+    i64 top = m_Top.load(std::memory_order_seq_cst);
+
+    if (top > bottom) {
+      m_Bottom.store(bottom + 1, std::memory_order_release);
+      return false;
+    }
+
+    out = m_Buffer[bottom & m_Mask].load(std::memory_order_relaxed);
+    if (top != bottom)
+      return true;
+
+    // Last item: race any thief for it.
+    bool won = m_Top.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+    m_Bottom.store(bottom + 1, std::memory_order_release);
+    return won;
+  }
+
+  // Any thread.
+  bool Steal(T &out) noexcept {
+    i64 top = m_Top.load(std::memory_order_seq_cst);
+    i64 bottom = m_Bottom.load(std::memory_order_seq_cst);
+    if (top >= bottom)
+      return false;
+
+    out = m_Buffer[top & m_Mask].load(std::memory_order_relaxed);
+    return m_Top.compare_exchange_strong(
+        top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+  }
+
+  // Approximate: racing pushes and steals may make it off by a few. Good
+  // enough for telemetry and for the pool's run-in-place depth check, which
+  // only compares it against a threshold.
+  u64 SizeApprox() const noexcept {
+    const i64 size = m_Bottom.load(std::memory_order_relaxed) -
+                     m_Top.load(std::memory_order_relaxed);
+    return size > 0 ? static_cast<u64>(size) : 0;
+  }
+
+  // Approximate; only exact when called by the owner with no thieves.
+  bool Empty() const noexcept {
+    return m_Bottom.load(std::memory_order_relaxed) <=
+           m_Top.load(std::memory_order_relaxed);
+  }
+
+private:
+  // Top and bottom live on separate cache lines: thieves hammer m_Top while
+  // the owner mostly touches m_Bottom.
+  alignas(64) std::atomic<i64> m_Top{0};
+  alignas(64) std::atomic<i64> m_Bottom{0};
+  std::unique_ptr<std::atomic<T>[]> m_Buffer;
+  i64 m_Mask{0};
+};
+
+} // namespace gecko::runtime